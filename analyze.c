@@ -0,0 +1,353 @@
+/*
+ * 五子棋游戏 - 批量局面分析
+ * 版权所有 (C) 2024 [大龙软件 bigdragonsoft.com]
+ *
+ * 文本输入整个映射进内存，按 ANALYZE_BATCH 行一批交给线程池；棋谱文件顺序读入，
+ * 每 ANALYZE_BATCH 局一批。每批的结果写进该批自己的缓冲区，一轮的批次全部完成后按顺序写出，
+ * 所以输出顺序与输入一致，与线程数无关。引擎和缓冲区开始时一次分配好，过程中不再分配。
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "analyze.h"
+#include "engine.h"
+#include "pool.h"
+#include "record.h"
+
+#define ANALYZE_BATCH 256     // 每批的行数
+#define BATCHES_PER_JOB 4     // 每轮每个工作线程分到的批数
+#define RECORD_MAX 160        // 一行输出的最大长度
+
+// 所有批次共享的状态
+typedef struct {
+    const AnalyzeConfig *config;
+    pthread_mutex_t lock;
+    engine_t **engines;       // 空闲的引擎，每个工作线程同时只用一个
+    int freeEngines;
+} Analyzer;
+
+// 一批局面的任务参数和结果
+typedef struct {
+    Analyzer *analyzer;
+    const char *start;        // 文本输入：该批第一行的开头
+    const char *end;          // 文本输入：该批最后一行之后
+    GameRecord *games;        // 棋谱输入：该批的对局，ANALYZE_BATCH 局的空间；文本输入时为 NULL
+    int gameCount;            // 棋谱输入：该批的局数
+    long firstLine;           // 第一行的行号或第一局的编号，从1开始
+    char *out;                // 输出缓冲区，ANALYZE_BATCH * RECORD_MAX 字节
+    size_t outLength;
+    long positions;           // 分析的局面数（不含跳过的行和出错的局面）
+    long errors;              // 出错的局面数
+} Batch;
+
+/**
+ * @brief 取当前时间（毫秒）
+ */
+static long long nowMs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ * @brief 从空棋盘走出一个局面并分析，把结果写进 out
+ * 
+ * @param e 引擎
+ * @param depth 搜索深度，0 表示只做静态评估
+ * @param label 输出中编号的键名（"line" 或 "game"）
+ * @param number 行号或对局编号
+ * @param rows 各步的行号
+ * @param cols 各步的列号
+ * @param moveCount 步数
+ * @param out 输出缓冲区，至少 RECORD_MAX 字节
+ * @return int 写入的字节数，局面不合法时为负数（取反后为字节数）
+ */
+static int analyzeMoves(engine_t *e, int depth, const char *label, long number,
+                        const uint8_t *rows, const uint8_t *cols, int moveCount, char *out) {
+    int winner = EMPTY;
+    engine_init(e);
+    for (int k = 0; k < moveCount; k++) {
+        if (winner != EMPTY || engine_stone(e, rows[k], cols[k]) != EMPTY) {
+            return -snprintf(out, RECORD_MAX, "{\"%s\":%ld,\"error\":\"illegal move %d\"}\n", label, number, k + 1);
+        }
+        int player = engine_to_move(e);
+        engine_make_move(e, rows[k], cols[k]);
+        if (engine_check_win(e, rows[k], cols[k])) winner = player;
+    }
+
+    int length = snprintf(out, RECORD_MAX, "{\"%s\":%ld,\"moves\":%d,\"eval\":%d",
+                          label, number, moveCount, engine_evaluate(e));
+    if (winner != EMPTY) {
+        length += snprintf(out + length, RECORD_MAX - length, ",\"winner\":\"%s\"}\n",
+                           winner == BLACK ? "black" : "white");
+        return length;
+    }
+    if (depth > 0) {
+        // 每个局面从空的置换表开始，结果不受同一引擎之前分析过的局面影响
+        engine_result_t result;
+        engine_clear_hash(e);
+        if (engine_search(e, &result) == 0) {
+            length += snprintf(out + length, RECORD_MAX - length, ",\"score\":%d,\"depth\":%d,\"move\":\"%c%c\"",
+                               result.score, result.depth, bookCoordChar(result.row), bookCoordChar(result.col));
+        } else {
+            length += snprintf(out + length, RECORD_MAX - length, ",\"move\":null");
+        }
+    }
+    length += snprintf(out + length, RECORD_MAX - length, "}\n");
+    return length;
+}
+
+/**
+ * @brief 分析一行局面，把结果写进 out
+ * 
+ * @param e 引擎
+ * @param depth 搜索深度，0 表示只做静态评估
+ * @param line 行的开头
+ * @param end 行尾（换行符或文件末尾）
+ * @param lineNumber 行号
+ * @param out 输出缓冲区，至少 RECORD_MAX 字节
+ * @return int 写入的字节数，跳过的行为0，出错的行为负数（取反后为字节数）
+ */
+static int analyzeLine(engine_t *e, int depth, const char *line, const char *end, long lineNumber, char *out) {
+    const char *p = line;
+    while (p < end && isspace((unsigned char)*p)) p++;
+    if (p == end || *p == '#') return 0;
+
+    int size = engine_size(e);
+    uint8_t rows[RECORD_MAX_MOVES], cols[RECORD_MAX_MOVES];
+    int moveCount = 0, n = 0;
+    for (; p < end; p++) {
+        if (isspace((unsigned char)*p)) continue;
+        int value = bookCoordValue(*p, size);
+        if (value < 0 || moveCount == size * size) {
+            return -snprintf(out, RECORD_MAX, "{\"line\":%ld,\"error\":\"bad coordinate at column %d\"}\n",
+                             lineNumber, (int)(p - line) + 1);
+        }
+        if (n == 0) {
+            rows[moveCount] = (uint8_t)value;
+            n = 1;
+        } else {
+            cols[moveCount++] = (uint8_t)value;
+            n = 0;
+        }
+    }
+    if (n != 0) {
+        return -snprintf(out, RECORD_MAX, "{\"line\":%ld,\"error\":\"incomplete move\"}\n", lineNumber);
+    }
+    return analyzeMoves(e, depth, "line", lineNumber, rows, cols, moveCount, out);
+}
+
+/**
+ * @brief 分析一批局面，结果写进该批的缓冲区
+ * 
+ * @param arg Batch
+ */
+static void analyzeBatch(void *arg) {
+    Batch *batch = arg;
+    Analyzer *analyzer = batch->analyzer;
+
+    pthread_mutex_lock(&analyzer->lock);
+    engine_t *e = analyzer->engines[--analyzer->freeEngines];
+    pthread_mutex_unlock(&analyzer->lock);
+
+    batch->outLength = 0;
+    batch->positions = 0;
+    batch->errors = 0;
+    int depth = analyzer->config->depth;
+    long number = batch->firstLine;
+    const char *line = batch->start;
+    for (int k = 0; batch->games ? k < batch->gameCount : line < batch->end; k++, number++) {
+        char *out = batch->out + batch->outLength;
+        int length;
+        if (batch->games != NULL) {
+            const GameRecord *game = &batch->games[k];
+            if (game->size != engine_size(e)) {
+                length = -snprintf(out, RECORD_MAX, "{\"game\":%ld,\"error\":\"board size %d\"}\n", number, game->size);
+            } else {
+                length = analyzeMoves(e, depth, "game", number, game->rows, game->cols, game->moveCount, out);
+            }
+        } else {
+            const char *newline = memchr(line, '\n', batch->end - line);
+            const char *end = newline ? newline : batch->end;
+            length = analyzeLine(e, depth, line, end, number, out);
+            line = end + 1;
+        }
+        if (length > 0) {
+            batch->positions++;
+        } else if (length < 0) {
+            batch->errors++;
+            length = -length;
+        }
+        batch->outLength += length;
+    }
+
+    pthread_mutex_lock(&analyzer->lock);
+    analyzer->engines[analyzer->freeEngines++] = e;
+    pthread_mutex_unlock(&analyzer->lock);
+}
+
+/**
+ * @brief 新建分析用的引擎
+ * 
+ * @param config 分析设置
+ * @return engine_t* 成功返回引擎，内存不足返回 NULL
+ */
+static engine_t *createEngine(const AnalyzeConfig *config) {
+    engine_t *e = engine_new_size(config->size);
+    if (e == NULL) return NULL;
+    if (engine_set_hash_size(e, config->hashMegabytes) != 0) {
+        engine_free(e);
+        return NULL;
+    }
+    engine_set_depth(e, config->depth > 0 ? config->depth : 1);
+    return e;
+}
+
+int runAnalyze(const AnalyzeConfig *config) {
+    // 棋谱文件顺序读取，文本文件整个映射进内存
+    RecordReader *reader = NULL;
+    const char *text = NULL;
+    size_t mapSize = 0;
+    if (recordIsFile(config->path)) {
+        reader = recordOpenReader(config->path);
+        if (reader == NULL) {
+            printf("Cannot open %s\n", config->path);
+            return 1;
+        }
+    } else {
+        int fd = open(config->path, O_RDONLY);
+        if (fd < 0) {
+            printf("Cannot open %s\n", config->path);
+            return 1;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            printf("Cannot read %s\n", config->path);
+            close(fd);
+            return 1;
+        }
+        mapSize = st.st_size;
+        if (mapSize > 0) {
+            void *map = mmap(NULL, mapSize, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (map == MAP_FAILED) {
+                printf("Cannot map %s\n", config->path);
+                close(fd);
+                return 1;
+            }
+            posix_madvise(map, mapSize, POSIX_MADV_SEQUENTIAL);
+            text = map;
+        }
+        close(fd);  // 映射在关闭文件后仍然有效
+    }
+
+    Analyzer analyzer;
+    analyzer.config = config;
+    analyzer.freeEngines = 0;
+    pthread_mutex_init(&analyzer.lock, NULL);
+
+    int window = config->jobs * BATCHES_PER_JOB;
+    int status = 0;
+    analyzer.engines = calloc(config->jobs, sizeof(engine_t *));
+    Batch *batches = calloc(window, sizeof(Batch));
+    char *buffers = malloc((size_t)window * ANALYZE_BATCH * RECORD_MAX);
+    GameRecord *games = reader ? malloc((size_t)window * ANALYZE_BATCH * sizeof(GameRecord)) : NULL;
+    ThreadPool *pool = NULL;
+    if (analyzer.engines != NULL && batches != NULL && buffers != NULL && (reader == NULL || games != NULL)) {
+        for (; analyzer.freeEngines < config->jobs; analyzer.freeEngines++) {
+            engine_t *e = createEngine(config);
+            if (e == NULL) break;
+            analyzer.engines[analyzer.freeEngines] = e;
+        }
+        if (analyzer.freeEngines == config->jobs) {
+            pool = poolCreate(config->jobs, window);
+        }
+    }
+    if (pool == NULL) {
+        printf("Cannot start %d analysis jobs\n", config->jobs);
+        status = 1;
+    }
+
+    long positions = 0, errors = 0;
+    long long start = nowMs();
+    const char *p = text, *end = text + mapSize;
+    long lineNumber = 1;
+    int more = 1;  // 棋谱输入：还没有读到文件末尾
+    while (status == 0 && (reader ? more : p < end)) {
+        // 一轮最多 window 批，每批 ANALYZE_BATCH 行或局
+        int count = 0;
+        for (; count < window && (reader ? more : p < end); count++) {
+            Batch *batch = &batches[count];
+            batch->analyzer = &analyzer;
+            batch->out = buffers + (size_t)count * ANALYZE_BATCH * RECORD_MAX;
+            batch->firstLine = lineNumber;
+            batch->games = NULL;
+            if (reader != NULL) {
+                batch->games = games + (size_t)count * ANALYZE_BATCH;
+                batch->gameCount = 0;
+                while (batch->gameCount < ANALYZE_BATCH) {
+                    int got = recordRead(reader, &batch->games[batch->gameCount]);
+                    if (got != 1) {
+                        if (got < 0) {
+                            printf("# damaged game record after game %ld\n", lineNumber - 1);
+                            status = 1;
+                        }
+                        more = 0;
+                        break;
+                    }
+                    batch->gameCount++;
+                    lineNumber++;
+                }
+            } else {
+                batch->start = p;
+                for (int k = 0; k < ANALYZE_BATCH && p < end; k++, lineNumber++) {
+                    const char *newline = memchr(p, '\n', end - p);
+                    p = newline ? newline + 1 : end;
+                }
+                batch->end = p;
+            }
+            poolSubmit(pool, analyzeBatch, batch);
+        }
+        poolWait(pool);
+        for (int k = 0; k < count; k++) {
+            fwrite(batches[k].out, 1, batches[k].outLength, stdout);
+            positions += batches[k].positions;
+            errors += batches[k].errors;
+        }
+    }
+
+    if (pool != NULL) {
+        long long elapsed = nowMs() - start;
+        printf("# analysed %ld positions in %lld ms (%lld positions/s)", positions, elapsed,
+               positions * 1000 / (elapsed > 0 ? elapsed : 1));
+        if (errors > 0) {
+            printf(", %ld bad positions", errors);
+        }
+        printf("\n");
+    }
+
+    poolDestroy(pool);
+    for (int k = 0; k < analyzer.freeEngines; k++) {
+        engine_free(analyzer.engines[k]);
+    }
+    free(games);
+    free(buffers);
+    free(batches);
+    free(analyzer.engines);
+    pthread_mutex_destroy(&analyzer.lock);
+    if (text != NULL) {
+        munmap((void *)text, mapSize);
+    }
+    recordCloseReader(reader);
+    return status != 0 || errors > 0 ? 1 : 0;
+}
@@ -0,0 +1,36 @@
+/*
+ * 五子棋游戏 - 批量局面分析
+ * 版权所有 (C) 2024 [大龙软件 bigdragonsoft.com]
+ *
+ * 从文件中读入大量局面，在线程池中逐个评估（可选固定深度搜索），
+ * 按输入顺序每个局面输出一行 JSON。
+ */
+
+#ifndef GOBANG_ANALYZE_H
+#define GOBANG_ANALYZE_H
+
+#include <stddef.h>
+
+/**
+ * 一次批量分析的设置
+ */
+typedef struct {
+    const char *path;       // 局面文件
+    int size;               // 棋盘边长
+    int depth;              // 搜索深度，0 表示只做静态评估
+    int jobs;               // 工作线程数，每个线程一个引擎
+    size_t hashMegabytes;   // 每个引擎的置换表大小
+} AnalyzeConfig;
+
+/**
+ * @brief 分析文件中的所有局面并输出到标准输出
+ * 
+ * 每行一个局面，写成从空棋盘开始的着法序列，每步为行字符加列字符（同开局库文本），
+ * 空格忽略，空行和以 # 开头的行跳过。文件是棋谱文件（见 record.h）时分析每局的终局局面。
+ * 
+ * @param config 分析设置
+ * @return int 程序退出状态
+ */
+int runAnalyze(const AnalyzeConfig *config);
+
+#endif
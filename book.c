@@ -0,0 +1,147 @@
+/*
+ * 五子棋游戏 - 开局库
+ * 版权所有 (C) 2024 [大龙软件 bigdragonsoft.com]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "book.h"
+
+// 文件头：8字节标识加记录数
+typedef struct {
+    char magic[8];
+    uint64_t count;
+} BookHeader;
+
+struct Book {
+    void *map;                // 映射的整个文件
+    size_t mapSize;
+    const BookEntry *entries; // 紧跟在文件头之后
+    size_t count;
+};
+
+Book *bookOpen(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(BookHeader)) {
+        close(fd);
+        return NULL;
+    }
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);  // 映射在关闭文件后仍然有效
+    if (map == MAP_FAILED) {
+        return NULL;
+    }
+
+    const BookHeader *header = map;
+    if (memcmp(header->magic, BOOK_MAGIC, sizeof(header->magic)) != 0 ||
+        header->count != ((size_t)st.st_size - sizeof(BookHeader)) / sizeof(BookEntry) ||
+        ((size_t)st.st_size - sizeof(BookHeader)) % sizeof(BookEntry) != 0) {
+        munmap(map, st.st_size);
+        return NULL;
+    }
+
+    Book *book = malloc(sizeof(Book));
+    if (book == NULL) {
+        munmap(map, st.st_size);
+        return NULL;
+    }
+    book->map = map;
+    book->mapSize = st.st_size;
+    book->entries = (const BookEntry *)(header + 1);
+    book->count = header->count;
+    return book;
+}
+
+int bookProbe(const Book *book, uint64_t key) {
+    // 二分查找第一条不小于 key 的记录
+    size_t low = 0, high = book->count;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (book->entries[mid].key < key) low = mid + 1;
+        else high = mid;
+    }
+
+    int move = -1, weight = -1;
+    for (size_t i = low; i < book->count && book->entries[i].key == key; i++) {
+        if (book->entries[i].weight > weight) {
+            weight = book->entries[i].weight;
+            move = book->entries[i].move;
+        }
+    }
+    return move;
+}
+
+size_t bookSize(const Book *book) {
+    return book->count;
+}
+
+void bookClose(Book *book) {
+    if (book == NULL) {
+        return;
+    }
+    munmap(book->map, book->mapSize);
+    free(book);
+}
+
+/**
+ * @brief 记录排序：先按局面哈希，再按着法
+ */
+static int compareEntries(const void *a, const void *b) {
+    const BookEntry *x = a, *y = b;
+    if (x->key != y->key) return x->key < y->key ? -1 : 1;
+    return (int)x->move - (int)y->move;
+}
+
+int bookCoordValue(char c, int size) {
+    int value = -1;
+    c = toupper((unsigned char)c);
+    if (c >= '0' && c <= '9') value = c - '0';
+    if (c >= 'A' && c <= 'Z') value = 10 + (c - 'A');
+    return value < size ? value : -1;
+}
+
+char bookCoordChar(int value) {
+    return value < 10 ? (char)('0' + value) : (char)('A' + value - 10);
+}
+
+long bookWrite(const char *path, BookEntry *entries, size_t count) {
+    qsort(entries, count, sizeof(BookEntry), compareEntries);
+
+    // 合并相同的局面和着法
+    size_t merged = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (merged > 0 && entries[merged - 1].key == entries[i].key && entries[merged - 1].move == entries[i].move) {
+            unsigned weight = entries[merged - 1].weight + entries[i].weight;
+            entries[merged - 1].weight = weight > UINT16_MAX ? UINT16_MAX : weight;
+        } else {
+            entries[merged] = entries[i];
+            entries[merged].reserved = 0;
+            merged++;
+        }
+    }
+
+    FILE *fp = fopen(path, "wb");
+    if (fp == NULL) {
+        return -1;
+    }
+    BookHeader header;
+    memcpy(header.magic, BOOK_MAGIC, sizeof(header.magic));
+    header.count = merged;
+    int ok = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+             fwrite(entries, sizeof(BookEntry), merged, fp) == merged;
+    if (fclose(fp) != 0) ok = 0;
+    return ok ? (long)merged : -1;
+}
@@ -0,0 +1,94 @@
+/*
+ * 五子棋游戏 - 开局库
+ * 版权所有 (C) 2024 [大龙软件 bigdragonsoft.com]
+ *
+ * 开局库文件是按局面哈希排序的定长记录，打开时整个文件映射进内存，
+ * 查找只做二分，不分配内存也不解析。记录按本机字节序存放。
+ */
+
+#ifndef GOBANG_BOOK_H
+#define GOBANG_BOOK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define BOOK_MAGIC "GOBANGBK"  // 文件头的8字节标识
+
+/**
+ * 开局库的一条记录：某个局面下的一个着法
+ */
+typedef struct {
+    uint64_t key;       // 按对称变换规范化后的局面哈希
+    uint16_t move;      // 规范化方向下的着法 row * 棋盘边长 + col
+    uint16_t weight;    // 权重（出现次数），同一局面取权重最大的着法
+    uint32_t reserved;  // 保留，写为0
+} BookEntry;
+
+typedef struct Book Book;
+
+/**
+ * @brief 打开开局库文件并映射进内存
+ * 
+ * @param path 文件路径
+ * @return Book* 成功返回开局库，文件不存在或格式不对返回 NULL
+ */
+Book *bookOpen(const char *path);
+
+/**
+ * @brief 查找某个局面的着法
+ * 
+ * 可以被多个线程同时调用。
+ * 
+ * @param book 开局库
+ * @param key 规范化后的局面哈希
+ * @return int 权重最大的着法编码，不在库中返回-1
+ */
+int bookProbe(const Book *book, uint64_t key);
+
+/**
+ * @brief 取开局库的记录数
+ * 
+ * @param book 开局库
+ * @return size_t 记录数
+ */
+size_t bookSize(const Book *book);
+
+/**
+ * @brief 解除映射并释放开局库
+ * 
+ * @param book 开局库，可以为 NULL
+ */
+void bookClose(Book *book);
+
+/**
+ * @brief 把开局记法中的一个坐标字符换算为行号或列号
+ * 
+ * 开局文本、局面文件、自对弈的输出和界面都用这种记法：0-9，10 以上为 A、B……，不分大小写。
+ * 
+ * @param c 坐标字符
+ * @param size 棋盘边长
+ * @return int 行号或列号，非法字符或超出棋盘返回-1
+ */
+int bookCoordValue(char c, int size);
+
+/**
+ * @brief 把行号或列号写成开局记法的坐标字符
+ * 
+ * @param value 行号或列号，0 到 35
+ * @return char 坐标字符（0-9、A-Z）
+ */
+char bookCoordChar(int value);
+
+/**
+ * @brief 写出开局库文件
+ * 
+ * 记录先按局面哈希和着法排序，相同的记录合并、权重相加。
+ * 
+ * @param path 文件路径
+ * @param entries 记录数组，写出时会被重新排列
+ * @param count 记录数
+ * @return int 成功返回写出的记录数，失败返回-1
+ */
+long bookWrite(const char *path, BookEntry *entries, size_t count);
+
+#endif
@@ -0,0 +1,2703 @@
+/*
+ * 五子棋引擎库 libgobang
+ * 版权所有 (C) 2024 [大龙软件 bigdragonsoft.com]
+ *
+ * 棋盘表示、局面评估和极小极大搜索。对外接口见 engine.h。
+ * 
+ * 本文件按每种棋盘尺寸各编译一次，BOARD_SIZE 由编译选项给出，
+ * 导出的只有该尺寸的函数表 engineOpsN（见 engineops.h）。
+ *
+ * Gobang engine library libgobang
+ * Copyright (C) 2024 [bigdragonsoft.com]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <limits.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "engineops.h"
+#include "pool.h"
+
+#ifndef BOARD_SIZE
+#define BOARD_SIZE ENGINE_DEFAULT_SIZE
+#endif
+
+#if BOARD_SIZE < 5 || BOARD_SIZE > ENGINE_MAX_SIZE
+#error "BOARD_SIZE must be between 5 and ENGINE_MAX_SIZE"
+#endif
+
+// 函数表的名字：engineOps 后接棋盘尺寸
+#define SIZED_NAME(name, size) SIZED_NAME_(name, size)
+#define SIZED_NAME_(name, size) name##size
+
+#define MAX_DEPTH 16
+#define SEARCH_RANGE 2
+
+// 搜索评分：有界的32位整数。静态评分饱和到 ±SCORE_EVAL_MAX，必胜分在其上，
+// INF 又在必胜分之上且远小于 INT32_MAX，取反、加减窗口半宽都不会溢出
+typedef int32_t score_t;
+
+// 必胜评分：从根节点数起第 n 步成五记为 WIN_SCORE - n，步数越少越好。
+// 绝对值不小于 WIN_BOUND 的评分表示必胜或必败
+#define WIN_SCORE ((score_t)ENGINE_WIN_SCORE)
+#define WIN_BOUND (WIN_SCORE - BOARD_SIZE * BOARD_SIZE)
+#define INF (WIN_SCORE + 1)
+#define NEG_INF (-INF)
+#define SCORE_EVAL_MAX (WIN_SCORE / 2)
+
+static inline score_t scoreMin(score_t a, score_t b) {
+    return a < b ? a : b;
+}
+
+static inline score_t scoreMax(score_t a, score_t b) {
+    return a > b ? a : b;
+}
+
+/**
+ * @brief 评分加上一个增量，结果饱和到 [NEG_INF, INF]
+ */
+static inline score_t scoreAdd(score_t score, long delta) {
+    long long sum = (long long)score + delta;
+    return (score_t)(sum < NEG_INF ? NEG_INF : sum > INF ? INF : sum);
+}
+
+/**
+ * @brief 把静态评分换成搜索评分，饱和到 ±SCORE_EVAL_MAX，不会与必胜分混淆
+ */
+static inline score_t scoreFromEval(int eval) {
+    return scoreMax(-SCORE_EVAL_MAX, scoreMin(SCORE_EVAL_MAX, eval));
+}
+
+/**
+ * @brief 第 ply 步成五的必胜评分
+ */
+static inline score_t scoreWinIn(int ply) {
+    return WIN_SCORE - ply;
+}
+
+/**
+ * @brief 对方第 ply 步成五的必败评分
+ */
+static inline score_t scoreLossIn(int ply) {
+    return -(WIN_SCORE - ply);
+}
+
+/**
+ * @brief 评分是否为必胜或必败
+ */
+static inline int scoreIsDecided(score_t score) {
+    return score >= WIN_BOUND || score <= -WIN_BOUND;
+}
+
+// 每个方向上的线条数（行、列各 BOARD_SIZE 条，两条对角线方向各 2*BOARD_SIZE-1 条）
+#define LINE_COUNT (2 * BOARD_SIZE - 1)
+
+// 位棋盘：每方、每个方向、每条线一个字，线上的格子依次占用低位，
+// 最高位留空作为填充，移位时不会串到相邻的线
+#if BOARD_SIZE < 16
+typedef uint16_t LineWord;
+#else
+typedef uint32_t LineWord;
+#endif
+
+// 格子编号 row * BOARD_SIZE + col
+#if BOARD_SIZE * BOARD_SIZE <= 256
+typedef uint8_t Cell;
+#else
+typedef uint16_t Cell;
+#endif
+
+static LineWord lineMask[4][LINE_COUNT];  // 每条线在棋盘内的格子，首次创建引擎时计算后只读
+
+// 棋盘的八种对称变换：第0位上下翻转，第1位左右翻转，第2位沿主对角线转置（最后做）。
+// 变换0为恒等变换
+#define SYMMETRY_COUNT 8
+
+// symmetryCell[t][cell] 为格子 cell（row * BOARD_SIZE + col）经变换 t 后的格子，首次创建引擎时计算
+static Cell symmetryCell[SYMMETRY_COUNT][BOARD_SIZE * BOARD_SIZE];
+
+// 棋型：以某个棋子为中心，沿一个方向前后各看四格（共九格）判定
+#define PATTERN_NONE        0
+#define PATTERN_OPEN_TWO    1  // 活二（含跳二），如 .XX... 、.X.X..
+#define PATTERN_THREE       2  // 眠三：只能冲成四
+#define PATTERN_OPEN_THREE  3  // 活三（含跳三），如 .XXX.. 、.X.XX.
+#define PATTERN_FOUR        4  // 冲四（含跳四），如 OXXXX. 、XX.XX
+#define PATTERN_OPEN_FOUR   5  // 活四 .XXXX.
+#define PATTERN_FIVE        6  // 五连
+#define PATTERN_COUNT       7
+
+/**
+ * 悔棋栈的一项：落子前被改动的增量状态
+ * 
+ * 提子时直接恢复这些值，不必重新评估。棋盘位和哈希按异或撤销，不必保存。
+ */
+typedef struct {
+    Cell cell;             // 落子的格子
+    uint8_t player;        // 落子方
+    int boardScore;
+    int lineScore[4];      // 经过该点的四条线原来的得分
+    uint32_t nearRow;      // 该行原来的邻域位集
+} UndoEntry;
+
+/**
+ * 棋盘及其增量维护的状态
+ * 
+ * 搜索时每个线程持有一份自己的副本，落子、提子只修改这份副本。
+ * 所有增量状态都只通过 makeMove()/unmakeMove() 修改。
+ */
+typedef struct {
+    unsigned char board[BOARD_SIZE][BOARD_SIZE];
+
+    const int *weights;                   // 各棋型（PATTERN_*）的得分，属于所在的引擎
+    int lineScore[4][LINE_COUNT];         // 每条线上的棋型得分（白正黑负）
+    int boardScore;                       // 所有线得分之和，与 evaluateBoard() 的结果一致
+
+    LineWord lineBits[2][4][LINE_COUNT];  // [黑/白][方向][线] 的棋子位
+
+    // 候选点：nearRows[row] 为该行棋子向左右各扩展 SEARCH_RANGE 格后的位集，
+    // 落子、提子时只需重算一行，生成着法时再与上下 SEARCH_RANGE 行合并
+    uint32_t nearRows[BOARD_SIZE];
+
+    // Zobrist 哈希值：symKeys[t] 为对称变换 t 后棋盘的哈希，symKeys[0] 即原棋盘
+    uint64_t symKeys[SYMMETRY_COUNT];
+
+    // 悔棋栈：每个棋子一项，按落子顺序排列，包括对局的棋和搜索中试下的棋。
+    // 每格最多一个棋子，栈不会溢出
+    UndoEntry undo[BOARD_SIZE * BOARD_SIZE];
+    int stoneCount;
+} Board;
+
+typedef struct {
+    int row;
+    int col;
+    int score;    // 着法排序用的分数
+    int pattern;  // 静态棋型分：在此落子己方成型与破坏对方成型的得分之和
+} Move;
+
+// 着法排序：置换表着法、成五、防守对方成五、杀手着法依次优先，
+// 其余按历史得分加静态预评分排序
+#define ORDER_HASH   1000000000
+#define ORDER_WIN    900000000
+#define ORDER_BLOCK  800000000
+#define ORDER_KILLER 700000000
+#define HISTORY_MAX  (1 << 24)
+
+// 后期着法削减（LMR）和前向剪枝：排序后前 lmrMoves 个着法和战术着法按完整深度搜索，
+// 其余着法在剩余深度不小于 LMR_MIN_DEPTH 时少搜 LMR_REDUCTION 层，
+// 静态棋型分为0（不成型也不挡对方成型）的直接剪掉。削减后的得分超过 alpha 时按完整深度重搜
+#define LMR_MIN_DEPTH  3
+#define LMR_REDUCTION  2
+
+// 搜索统计：定义 ENGINE_STATS 时每个搜索线程各自计数，搜索结束后汇总
+#ifdef ENGINE_STATS
+typedef struct {
+    unsigned long long evaluations;
+    unsigned long long ttProbes;
+    unsigned long long ttHits;
+    unsigned long long cutoffs;
+    unsigned long long cutoffsAt[ENGINE_CUTOFF_SLOTS];
+} SearchStats;
+
+#define STAT_ADD(t, field) ((t)->stats.field++)
+#define STAT_CUTOFF(t, k) ((t)->stats.cutoffs++, \
+    (t)->stats.cutoffsAt[(k) < ENGINE_CUTOFF_SLOTS ? (k) : ENGINE_CUTOFF_SLOTS - 1]++)
+#else
+#define STAT_ADD(t, field) ((void)0)
+#define STAT_CUTOFF(t, k) ((void)0)
+#endif
+
+#if MAX_DEPTH > ENGINE_STATS_DEPTHS
+#error "ENGINE_STATS_DEPTHS must cover every search depth"
+#endif
+
+/**
+ * 每个搜索线程的私有状态
+ */
+typedef struct {
+    Engine *engine;                         // 所属引擎，提供置换表和搜索控制
+    Board board;                              // 该线程的棋盘副本
+    Move killers[MAX_DEPTH][2];               // 每层最近引起截断的两个着法
+    int history[2][BOARD_SIZE * BOARD_SIZE];  // [黑/白][着法] 的历史得分
+    unsigned long long nodes;                 // 本次搜索的节点数
+#ifdef ENGINE_STATS
+    SearchStats stats;                        // 本次搜索的统计
+#endif
+} SearchThread;
+
+// 搜索控制：限时模式下每隔 SEARCH_CHECK_NODES 个节点检查一次时间
+#define SEARCH_CHECK_NODES 1024
+
+// Zobrist 哈希：每方每个格子一个随机键，落子、提子时异或更新
+// 首次创建引擎时生成，之后只读
+static uint64_t zobrist[2][BOARD_SIZE][BOARD_SIZE];
+static uint64_t zobristSide;  // 轮到黑方走时额外异或
+
+// 某方在格子 row * BOARD_SIZE + col 上的键
+#define ZOBRIST_CELL(player, cell) (zobrist[(player) - 1][(cell) / BOARD_SIZE][(cell) % BOARD_SIZE])
+
+// 置换表：每桶4项共64字节，正好占一条缓存行
+#define TT_BUCKET_SIZE 4
+#define TT_NO_MOVE 0xFFFF
+#define TT_MOVE_MASK 0x3FF  // 表中着法占10位，全1表示 TT_NO_MOVE
+#define TT_GENERATIONS 64   // 代号的个数，清空置换表时换下一个代号
+
+#if BOARD_SIZE * BOARD_SIZE >= TT_MOVE_MASK
+#error "TT_MOVE_MASK must cover every cell"
+#endif
+
+#define TT_EXACT 1  // 精确值
+#define TT_LOWER 2  // 下界（发生 beta 截断）
+#define TT_UPPER 3  // 上界（所有着法都不超过 alpha）
+
+// data 按位打包：评分 0-31，着法 32-41，代号 42-47，深度 48-55，类型 56-57，代数 58-63
+#define TT_FLAG(data) ((int)(((data) >> 56) & 0x3))
+#define TT_AGE(data) ((int)(((data) >> 58) & 0x3F))
+#define TT_GENERATION(data) ((int)(((data) >> 42) & 0x3F))
+
+// 类型为0的空项和代号不是当前代号的旧项都当作空项
+#define TT_LIVE(e, data) (TT_FLAG(data) != 0 && TT_GENERATION(data) == (e)->ttGeneration)
+
+// 多线程共享置换表且不加锁：key 中存的是局面哈希与 data 的异或，
+// 两个字段若被不同线程写了一半，读出时校验不通过，当作未命中
+typedef struct {
+    uint64_t key;
+    uint64_t data;
+} TTEntry;
+
+typedef struct {
+    TTEntry entry[TT_BUCKET_SIZE];
+} TTBucket;
+
+/**
+ * 引擎：一盘对局的全部状态
+ */
+struct Engine {
+    Board board;                          // 对局棋盘
+    int toMove;                           // 轮到走棋的一方，已下的棋在棋盘的悔棋栈中
+
+    int depth;                            // 固定搜索深度
+    int timeLimitMs;                      // 每步思考时间（毫秒），0 表示按 depth 固定深度搜索
+    unsigned long threatNodes;            // 搜索前 VCF/VCT 求解的节点预算，0 表示不求解
+    int aspiration;                       // 根节点搜索窗口的半宽，0 表示用完整窗口
+    int lmrMoves;                         // 按完整深度搜索的着法数，之后的削减或剪掉，0 表示不削减
+    const Book *book;                     // 开局库，NULL 表示不用
+    int weights[PATTERN_COUNT];           // 本引擎评估用的各棋型得分
+
+    TTBucket *ttTable;
+    size_t ttBuckets;                     // 桶数，除限定内存的引擎外总是2的幂
+    size_t ttCapacity;                    // 限定内存时内存块中置换表最多能放的桶数
+    size_t ttMegabytes;                   // 分配置换表时的内存预算
+    int ttAge;                            // 每次搜索加一，用于淘汰旧局面
+    int ttGeneration;                     // 当前代号，engine_clear_hash() 换下一个，旧代号的项即失效
+    int ttClears;                         // 上次真正清零以来换过的代号数
+
+    size_t arenaBytes;                    // 限定内存时引擎、搜索线程和置换表共用的内存块大小，否则为0
+
+    SearchThread *threads;                // threadCount 个线程的私有状态
+    int threadCount;
+    ThreadPool *pool;                     // 多线程搜索时的工作线程，单线程时为 NULL
+
+    long long deadline;                   // 截止时间（毫秒），0 表示不限时
+    volatile int stopped;                 // 任一线程发现超时后置1，所有线程随即退出
+
+    pthread_t ponderThread;               // 后台思考的线程
+    int pondering;                        // 后台思考线程在运行时为1
+    volatile int ponderDepth;             // 后台思考已完成的深度
+
+#ifdef ENGINE_STATS
+    engine_stats_t stats;                 // 最近一次搜索的统计
+#endif
+};
+
+static pthread_once_t tablesOnce = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief 计算经过某点的线在某方向上的索引
+ * 
+ * @param d 方向编号（0 横、1 竖、2 主对角线、3 反对角线）
+ * @param row 行号
+ * @param col 列号
+ * @return int 线索引
+ */
+static int lineIndex(int d, int row, int col) {
+    switch (d) {
+        case 0: return row;
+        case 1: return col;
+        case 2: return row - col + BOARD_SIZE - 1;
+        default: return row + col;
+    }
+}
+
+/**
+ * @brief 计算某点在线位棋盘中的位号
+ * 
+ * 沿方向前进一步位号加一（反对角线为减一），因此同一条线上相邻的格子在位棋盘中也相邻。
+ * 
+ * @param d 方向编号
+ * @param row 行号
+ * @param col 列号
+ * @return int 位号
+ */
+static int linePos(int d, int row, int col) {
+    return d == 1 ? row : col;
+}
+
+/**
+ * @brief 初始化每条线在棋盘内的格子掩码
+ */
+static void initLineMasks(void) {
+    memset(lineMask, 0, sizeof(lineMask));
+    for (int i = 0; i < BOARD_SIZE; i++) {
+        for (int j = 0; j < BOARD_SIZE; j++) {
+            for (int d = 0; d < 4; d++) {
+                lineMask[d][lineIndex(d, i, j)] |= (LineWord)(1u << linePos(d, i, j));
+            }
+        }
+    }
+}
+
+/**
+ * @brief 对格子坐标做对称变换
+ * 
+ * @param t 变换编号
+ * @param row 行号
+ * @param col 列号
+ * @param r 输出：变换后的行号
+ * @param c 输出：变换后的列号
+ */
+static void transformCell(int t, int row, int col, int *r, int *c) {
+    if (t & 1) row = BOARD_SIZE - 1 - row;
+    if (t & 2) col = BOARD_SIZE - 1 - col;
+    if (t & 4) {
+        int tmp = row;
+        row = col;
+        col = tmp;
+    }
+    *r = row;
+    *c = col;
+}
+
+/**
+ * @brief transformCell() 的逆变换
+ */
+static void inverseCell(int t, int row, int col, int *r, int *c) {
+    if (t & 4) {
+        int tmp = row;
+        row = col;
+        col = tmp;
+    }
+    if (t & 1) row = BOARD_SIZE - 1 - row;
+    if (t & 2) col = BOARD_SIZE - 1 - col;
+    *r = row;
+    *c = col;
+}
+
+/**
+ * @brief 生成对称变换的格子对照表
+ */
+static void initSymmetry(void) {
+    for (int t = 0; t < SYMMETRY_COUNT; t++) {
+        for (int i = 0; i < BOARD_SIZE; i++) {
+            for (int j = 0; j < BOARD_SIZE; j++) {
+                int r, c;
+                transformCell(t, i, j, &r, &c);
+                symmetryCell[t][i * BOARD_SIZE + j] = (Cell)(r * BOARD_SIZE + c);
+            }
+        }
+    }
+}
+
+/**
+ * @brief 初始化棋盘
+ * 
+ * 将棋盘上所有位置初始化为空（'.'）
+ * 
+ * @param b 棋盘
+ * @param weights 各棋型的得分
+ */
+static void initBoard(Board *b, const int *weights) {
+    for (int i = 0; i < BOARD_SIZE; i++) {
+        for (int j = 0; j < BOARD_SIZE; j++) {
+            b->board[i][j] = EMPTY;
+        }
+    }
+    b->weights = weights;
+    memset(b->lineScore, 0, sizeof(b->lineScore));
+    b->boardScore = 0;
+    memset(b->lineBits, 0, sizeof(b->lineBits));
+    memset(b->nearRows, 0, sizeof(b->nearRows));
+    memset(b->symKeys, 0, sizeof(b->symKeys));
+    b->stoneCount = 0;
+}
+
+/**
+ * @brief 五连检测：返回所有五连起点的位集
+ * 
+ * @param x 一条线上的己方棋子位
+ * @return uint32_t 第 s 位为1表示 s..s+4 五格都是己方棋子
+ */
+static inline uint32_t fiveMask(uint32_t x) {
+    return x & (x >> 1) & (x >> 2) & (x >> 3) & (x >> 4);
+}
+
+/**
+ * @brief 活四检测：返回所有活四（两端为空的四连）起点的位集
+ * 
+ * @param x 己方棋子位
+ * @param e 空位
+ * @return uint32_t 第 s 位为1表示 s..s+3 为己方四连且 s-1、s+4 为空
+ */
+static inline uint32_t openFourMask(uint32_t x, uint32_t e) {
+    return x & (x >> 1) & (x >> 2) & (x >> 3) & (e << 1) & (e >> 4);
+}
+
+/**
+ * @brief 冲四检测：返回落子即可成五的空位
+ * 
+ * 在每个五格窗口中，若恰有四个己方棋子和一个空位，则该空位为成五点。
+ * 
+ * @param x 己方棋子位
+ * @param e 空位
+ * @return uint32_t 成五点的位集，非零表示该线上有四
+ */
+static inline uint32_t winPoints(uint32_t x, uint32_t e) {
+    uint32_t points = 0;
+    for (int j = 0; j < 5; j++) {
+        uint32_t w = e >> j;
+        for (int k = 0; k < 5; k++) {
+            if (k != j) w &= x >> k;
+        }
+        points |= w << j;
+    }
+    return points;
+}
+
+/**
+ * @brief 活三检测：返回落子即可成活四的空位
+ * 
+ * 在每个六格窗口中，若两端为空，中间四格恰有三个己方棋子和一个空位，则该空位为活四点。
+ * 同时覆盖连三（.XXX..）和跳三（.X.XX.）。
+ * 
+ * @param x 己方棋子位
+ * @param e 空位
+ * @return uint32_t 活四点的位集，非零表示该线上有活三
+ */
+static inline uint32_t openFourPoints(uint32_t x, uint32_t e) {
+    uint32_t ends = e & (e >> 5);
+    uint32_t points = 0;
+    for (int j = 1; j <= 4; j++) {
+        uint32_t w = ends & (e >> j);
+        for (int k = 1; k <= 4; k++) {
+            if (k != j) w &= x >> k;
+        }
+        points |= w << j;
+    }
+    return points;
+}
+
+/**
+ * @brief 取某方在某条线上的棋子位与被堵位
+ * 
+ * 被堵位包括对方的棋子和棋盘外的填充位。
+ */
+#define LINE_OWN(b, player, d, index) ((uint32_t)(b)->lineBits[(player) - 1][d][index])
+#define LINE_BLOCKED(b, player, d, index) \
+    ((uint32_t)(b)->lineBits[2 - (player)][d][index] | ~(uint32_t)lineMask[d][index])
+#define LINE_EMPTY(b, d, index) \
+    ((uint32_t)lineMask[d][index] & ~(uint32_t)((b)->lineBits[0][d][index] | (b)->lineBits[1][d][index]))
+
+/**
+ * @brief 检查某方在某点落子后是否成五
+ * 
+ * 该点可以为空，也可以已有该方的棋子。
+ * 
+ * @param b 棋盘
+ * @param row 行号
+ * @param col 列号
+ * @param player 落子方
+ * @return int 成五返回1，否则返回0
+ */
+static int isWinningMove(const Board *b, int row, int col, int player) {
+    for (int d = 0; d < 4; d++) {
+        int pos = linePos(d, row, col);
+        // 起点在 pos-4..pos 之间的五连才经过该点
+        uint32_t window = (0x1Fu << pos) >> 4;
+        uint32_t own = LINE_OWN(b, player, d, lineIndex(d, row, col)) | (1u << pos);
+        if (fiveMask(own) & window) return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief 检查是否有五子连珠
+ * 
+ * @param b 棋盘
+ * @param row 最后一步棋的行号
+ * @param col 最后一步棋的列号
+ * @return int 如果有五子连珠返回1，否则返回0
+ */
+static int checkWin(const Board *b, int row, int col) {
+    int player = b->board[row][col];
+    if (player == EMPTY) return 0;
+    return isWinningMove(b, row, col, player);
+}
+
+/**
+ * @brief 由线索引和位号还原格子坐标，是 lineIndex()、linePos() 的逆运算
+ * 
+ * @param d 方向编号
+ * @param index 线索引
+ * @param pos 位号
+ * @param row 输出：行号
+ * @param col 输出：列号
+ */
+static void lineCell(int d, int index, int pos, int *row, int *col) {
+    switch (d) {
+        case 0: *row = index; *col = pos; break;
+        case 1: *row = pos; *col = index; break;
+        case 2: *row = index + pos - BOARD_SIZE + 1; *col = pos; break;
+        default: *row = index - pos; *col = pos; break;
+    }
+}
+
+/**
+ * @brief 统计某方的成五点
+ * 
+ * 同一个点可能同时出现在几条线上，只计一次。
+ * 
+ * @param b 棋盘
+ * @param player 棋子颜色
+ * @param row 输出：其中一个成五点的行号
+ * @param col 输出：其中一个成五点的列号
+ * @return int 成五点个数，最多数到2
+ */
+static int countWinPoints(const Board *b, int player, int *row, int *col) {
+    int count = 0;
+    for (int d = 0; d < 4; d++) {
+        for (int index = 0; index < LINE_COUNT; index++) {
+            uint32_t own = LINE_OWN(b, player, d, index);
+            if (__builtin_popcount(own) < 4) continue;
+            uint32_t points = winPoints(own, LINE_EMPTY(b, d, index));
+            while (points) {
+                int r, c;
+                lineCell(d, index, __builtin_ctz(points), &r, &c);
+                points &= points - 1;
+                if (count == 0) {
+                    *row = r;
+                    *col = c;
+                    count = 1;
+                } else if (r != *row || c != *col) {
+                    return 2;
+                }
+            }
+        }
+    }
+    return count;
+}
+
+#define PATTERN_WINDOW 9                  // 窗口格数，中心为第4格
+#define PATTERN_INDICES 19683             // 3 的 9 次方
+#define PATTERN_SPAN ((1u << PATTERN_WINDOW) - 1)
+
+// 各棋型的默认得分，引擎可以另设
+static const int defaultWeights[PATTERN_COUNT] = { 0, 100, 100, 1000, 1000, 10000, 100000 };
+
+// 窗口中每格为 0 空、1 己方、2 被堵（对方棋子或棋盘外），按三进制编为下标。
+// base3[m] 把9位掩码 m 中为1的位 k 换算成 3^k 之和，于是
+// 下标 = base3[己方位] + 2 * base3[被堵位]。两张表首次创建引擎时生成，之后只读
+static uint16_t base3[1 << PATTERN_WINDOW];
+static uint8_t patternTable[PATTERN_INDICES];
+
+/**
+ * @brief 判定九格窗口中心棋子的棋型
+ * 
+ * 依次检查经过中心的五格、六格子窗口，取最高的棋型。
+ * 
+ * @param cells 九格窗口，0 空、1 己方、2 被堵，中心 cells[4] 为己方
+ * @return int 棋型（PATTERN_*）
+ */
+static int classifyWindow(const int cells[PATTERN_WINDOW]) {
+    int best = PATTERN_NONE;
+
+    // 五格子窗口 s..s+4，都经过中心
+    for (int s = 0; s + 5 <= PATTERN_WINDOW; s++) {
+        int own = 0, empty = 0;
+        for (int k = s; k < s + 5; k++) {
+            if (cells[k] == 1) own++;
+            else if (cells[k] == 0) empty++;
+        }
+        if (own == 5) return PATTERN_FIVE;
+        if (own == 4 && empty == 1 && best < PATTERN_FOUR) best = PATTERN_FOUR;
+        if (own == 3 && empty == 2 && best < PATTERN_THREE) best = PATTERN_THREE;
+    }
+
+    // 六格子窗口 s..s+5：两端为空，中间四格（都经过中心）决定活四、活三、活二
+    for (int s = 0; s + 6 <= PATTERN_WINDOW; s++) {
+        if (cells[s] != 0 || cells[s + 5] != 0) continue;
+        int own = 0, empty = 0;
+        for (int k = s + 1; k <= s + 4; k++) {
+            if (cells[k] == 1) own++;
+            else if (cells[k] == 0) empty++;
+        }
+        if (own == 4) return PATTERN_OPEN_FOUR;
+        if (own == 3 && empty == 1 && best < PATTERN_OPEN_THREE) best = PATTERN_OPEN_THREE;
+        if (own == 2 && empty == 2 && best < PATTERN_OPEN_TWO) best = PATTERN_OPEN_TWO;
+    }
+    return best;
+}
+
+/**
+ * @brief 生成三进制换算表和棋型表
+ */
+static void initPatterns(void) {
+    for (int m = 0; m < (1 << PATTERN_WINDOW); m++) {
+        int value = 0;
+        for (int k = PATTERN_WINDOW - 1; k >= 0; k--) {
+            value = value * 3 + ((m >> k) & 1);
+        }
+        base3[m] = (uint16_t)value;
+    }
+
+    for (int index = 0; index < PATTERN_INDICES; index++) {
+        int cells[PATTERN_WINDOW];
+        int rest = index;
+        for (int k = 0; k < PATTERN_WINDOW; k++) {
+            cells[k] = rest % 3;
+            rest /= 3;
+        }
+        patternTable[index] = cells[4] == 1 ? (uint8_t)classifyWindow(cells) : PATTERN_NONE;
+    }
+}
+
+/**
+ * @brief 评估某点在一条线上的棋型
+ * 
+ * 取该点前后各四格组成窗口，查一次棋型表。该点为空时按己方已在此落子计算。
+ * 
+ * @param weights 各棋型的得分
+ * @param own 己方棋子位
+ * @param blocked 被堵位（对方棋子和棋盘外）
+ * @param pos 该点的位号
+ * @return int 该方向的棋型得分
+ */
+static int directionScore(const int *weights, uint32_t own, uint32_t blocked, int pos) {
+    // 整体左移四位，使窗口起点不为负；移入的低四位在棋盘外，算作被堵
+    uint32_t x = ((own | (1u << pos)) << 4) >> pos;
+    uint32_t o = (((blocked << 4) | 0xF) >> pos);
+    return weights[patternTable[base3[x & PATTERN_SPAN] + 2 * base3[o & PATTERN_SPAN]]];
+}
+
+/**
+ * @brief 评估棋盘状态
+ * 
+ * @param b 棋盘
+ * @param row 最后一步棋的行号
+ * @param col 最后一步棋的列号
+ * @param player 当前玩家的棋符号
+ * @return int 盘状态的评分
+ */
+static int evaluatePosition(const Board *b, int row, int col, int player) {
+    int score = 0;
+    
+    for (int d = 0; d < 4; d++) {
+        int index = lineIndex(d, row, col);
+        score += directionScore(b->weights, LINE_OWN(b, player, d, index), LINE_BLOCKED(b, player, d, index),
+                                linePos(d, row, col));
+    }
+    
+    return score;
+}
+
+/**
+ * @brief 评估一条线上所有棋子在该方向上的得分
+ * 
+ * 对线上每个棋子查一次棋型表，规则与 evaluatePosition() 相同，
+ * 因此所有线得分之和与 evaluateBoard() 完全一致。
+ * 
+ * @param b 棋盘
+ * @param d 方向编号
+ * @param index 线索引
+ * @return int 该线的得分（白正黑负）
+ */
+static int evaluateLine(const Board *b, int d, int index) {
+    int score = 0;
+
+    for (int player = BLACK; player <= WHITE; player++) {
+        uint32_t own = LINE_OWN(b, player, d, index);
+        uint32_t blocked = LINE_BLOCKED(b, player, d, index);
+        int sum = 0;
+
+        for (uint32_t bits = own; bits; bits &= bits - 1) {
+            sum += directionScore(b->weights, own, blocked, __builtin_ctz(bits));
+        }
+        score += player == WHITE ? sum : -sum;
+    }
+    return score;
+}
+
+/**
+ * @brief 逐线累加整个棋盘的得分，所有平台可用
+ * 
+ * @param b 棋盘
+ * @return int 棋盘状态的评分
+ */
+static int scanLines(const Board *b) {
+    int score = 0;
+    for (int d = 0; d < 4; d++) {
+        for (int index = 0; index < LINE_COUNT; index++) {
+            score += evaluateLine(b, d, index);
+        }
+    }
+    return score;
+}
+
+// 整盘向量扫描：把棋盘展开成每方一张网格，每格一字节，为该方视角下的三进制格值
+// （0 空、1 己方、2 被堵），四周各补 GRID_PAD 格被堵。以棋盘 (r, c) 为中心、沿方向 d 的
+// 九格窗口从网格 (r, c) 格之后 gridStart[d] 处起，每格前进 gridStep[d]，同一行上的中心
+// 在网格中连续存放，于是一次可以算出一整段中心的窗口下标：
+// index = cell0 + 3 * cell1 + ... + 6561 * cell8，与 directionScore() 的下标相同，
+// 最大为 19682，放得进16位
+#define GRID_PAD 4
+#define GRID_ROWS (BOARD_SIZE + 2 * GRID_PAD)
+#define GRID_INDICES ((BOARD_SIZE + 15) / 16 * 16)      // 一行算出的下标数，按最长的段向上取整
+#define GRID_WIDTH (GRID_INDICES + 2 * GRID_PAD)        // 最后一段的窗口读到第 GRID_INDICES + 7 列
+
+typedef uint8_t GridRow[GRID_WIDTH];
+
+// 四个方向上第0个中心的窗口第0格相对网格行首的位置，以及窗口内相邻两格的距离
+static const int gridStart[4] = { GRID_PAD * GRID_WIDTH, GRID_PAD, 0, 2 * GRID_PAD * GRID_WIDTH };
+static const int gridStep[4] = { 1, GRID_WIDTH, GRID_WIDTH + 1, 1 - GRID_WIDTH };
+
+/**
+ * @brief 一行中心在四个方向上的窗口下标
+ * 
+ * index[d][c] 为 origin[gridStart[d] + k * gridStep[d] + c]（k = 0..8）按三进制组成的数。
+ * 
+ * @param origin 该行在网格中往上 GRID_PAD 行的行首
+ * @param index 输出：每个方向 GRID_INDICES 个下标，只有前 BOARD_SIZE 个有意义
+ */
+typedef void (*GridKernel)(const uint8_t *origin, uint16_t index[4][GRID_INDICES]);
+
+/**
+ * @brief 用网格扫描评估整个棋盘，窗口下标由向量实现 kernel 算出
+ * 
+ * 只扫描有该方棋子的行，每行一次算出四个方向的下标，再对行上的每个棋子查表。
+ * 
+ * @param b 棋盘
+ * @param kernel 窗口下标的向量实现
+ * @return int 棋盘状态的评分，与 scanLines() 相同
+ */
+static int scanGrid(const Board *b, GridKernel kernel) {
+    GridRow grid[2][GRID_ROWS];
+    uint16_t index[4][GRID_INDICES];
+    int score = 0;
+
+    // 黑方视角下格值就是棋盘上的值（黑1白2），白方视角下黑白互换
+    memset(grid, 2, sizeof(grid));
+    for (int i = 0; i < BOARD_SIZE; i++) {
+        for (int j = 0; j < BOARD_SIZE; j++) {
+            int v = b->board[i][j];
+            grid[0][i + GRID_PAD][j + GRID_PAD] = (uint8_t)v;
+            grid[1][i + GRID_PAD][j + GRID_PAD] = (uint8_t)(v == EMPTY ? 0 : 3 - v);
+        }
+    }
+
+    for (int player = BLACK; player <= WHITE; player++) {
+        GridRow *cells = grid[player - 1];
+        int sum = 0;
+        for (int r = 0; r < BOARD_SIZE; r++) {
+            uint32_t own = LINE_OWN(b, player, 0, r);
+            if (!own) continue;
+            kernel(cells[r], index);
+            for (uint32_t bits = own; bits; bits &= bits - 1) {
+                int c = __builtin_ctz(bits);
+                for (int d = 0; d < 4; d++) {
+                    sum += b->weights[patternTable[index[d][c]]];
+                }
+            }
+        }
+        score += player == WHITE ? sum : -sum;
+    }
+    return score;
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+
+// SSE4.1：十六个中心一段。窗口前四格、后四格的三进制数都不超过80，先在8位上算出，
+// 零扩展成16位后再与第九格合成 index = low + 81 * high + 6561 * cell8
+#define SSE_CELL(d, k) _mm_loadu_si128((const __m128i *)(origin + gridStart[d] + (k) * gridStep[d] + c))
+#define SSE_TIMES3(x) _mm_add_epi8(x, _mm_add_epi8(x, x))
+
+__attribute__((target("sse4.1")))
+static void gridIndicesSse41(const uint8_t *origin, uint16_t index[4][GRID_INDICES]) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i w81 = _mm_set1_epi16(81), w6561 = _mm_set1_epi16(6561);
+    for (int c = 0; c < BOARD_SIZE; c += 16) {
+        for (int d = 0; d < 4; d++) {
+            __m128i low = SSE_CELL(d, 3), high = SSE_CELL(d, 7), last = SSE_CELL(d, 8);
+            for (int k = 2; k >= 0; k--) {
+                low = _mm_add_epi8(SSE_TIMES3(low), SSE_CELL(d, k));
+                high = _mm_add_epi8(SSE_TIMES3(high), SSE_CELL(d, k + 4));
+            }
+            __m128i first = _mm_add_epi16(_mm_cvtepu8_epi16(low),
+                                          _mm_add_epi16(_mm_mullo_epi16(_mm_cvtepu8_epi16(high), w81),
+                                                        _mm_mullo_epi16(_mm_cvtepu8_epi16(last), w6561)));
+            __m128i second = _mm_add_epi16(_mm_unpackhi_epi8(low, zero),
+                                           _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(high, zero), w81),
+                                                         _mm_mullo_epi16(_mm_unpackhi_epi8(last, zero), w6561)));
+            _mm_storeu_si128((__m128i *)(index[d] + c), first);
+            _mm_storeu_si128((__m128i *)(index[d] + c + 8), second);
+        }
+    }
+}
+
+// AVX2：与 SSE4.1 相同，合成下标时十六个中心一次算完
+__attribute__((target("avx2")))
+static void gridIndicesAvx2(const uint8_t *origin, uint16_t index[4][GRID_INDICES]) {
+    const __m256i w81 = _mm256_set1_epi16(81), w6561 = _mm256_set1_epi16(6561);
+    for (int c = 0; c < BOARD_SIZE; c += 16) {
+        for (int d = 0; d < 4; d++) {
+            __m128i low = SSE_CELL(d, 3), high = SSE_CELL(d, 7), last = SSE_CELL(d, 8);
+            for (int k = 2; k >= 0; k--) {
+                low = _mm_add_epi8(SSE_TIMES3(low), SSE_CELL(d, k));
+                high = _mm_add_epi8(SSE_TIMES3(high), SSE_CELL(d, k + 4));
+            }
+            __m256i sum = _mm256_add_epi16(_mm256_cvtepu8_epi16(low),
+                                           _mm256_add_epi16(_mm256_mullo_epi16(_mm256_cvtepu8_epi16(high), w81),
+                                                            _mm256_mullo_epi16(_mm256_cvtepu8_epi16(last), w6561)));
+            _mm256_storeu_si256((__m256i *)(index[d] + c), sum);
+        }
+    }
+}
+
+static int scanGridSse41(const Board *b) {
+    return scanGrid(b, gridIndicesSse41);
+}
+
+static int scanGridAvx2(const Board *b) {
+    return scanGrid(b, gridIndicesAvx2);
+}
+#endif
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+
+// NEON：与 SSE4.1 相同，十六个中心一段，AArch64 上总是可用
+#define NEON_CELL(d, k) vld1q_u8(origin + gridStart[d] + (k) * gridStep[d] + c)
+
+static void gridIndicesNeon(const uint8_t *origin, uint16_t index[4][GRID_INDICES]) {
+    for (int c = 0; c < BOARD_SIZE; c += 16) {
+        for (int d = 0; d < 4; d++) {
+            uint8x16_t low = NEON_CELL(d, 3), high = NEON_CELL(d, 7), last = NEON_CELL(d, 8);
+            for (int k = 2; k >= 0; k--) {
+                low = vmlaq_n_u8(NEON_CELL(d, k), low, 3);
+                high = vmlaq_n_u8(NEON_CELL(d, k + 4), high, 3);
+            }
+            uint16x8_t first = vmlaq_n_u16(vmlaq_n_u16(vmovl_u8(vget_low_u8(low)), vmovl_u8(vget_low_u8(high)), 81),
+                                           vmovl_u8(vget_low_u8(last)), 6561);
+            uint16x8_t second = vmlaq_n_u16(vmlaq_n_u16(vmovl_u8(vget_high_u8(low)), vmovl_u8(vget_high_u8(high)), 81),
+                                            vmovl_u8(vget_high_u8(last)), 6561);
+            vst1q_u16(index[d] + c, first);
+            vst1q_u16(index[d] + c + 8, second);
+        }
+    }
+}
+
+static int scanGridNeon(const Board *b) {
+    return scanGrid(b, gridIndicesNeon);
+}
+#endif
+
+// 整盘评估的实现，selectScanBoard() 按处理器支持的指令集选定，之后只读
+static int (*scanBoard)(const Board *b) = scanLines;
+
+/**
+ * @brief 按处理器支持的指令集选择整盘评估的实现，没有可用的向量指令时逐线计算
+ */
+static void selectScanBoard(void) {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        scanBoard = scanGridAvx2;
+    } else if (__builtin_cpu_supports("sse4.1")) {
+        scanBoard = scanGridSse41;
+    }
+#elif defined(__aarch64__)
+    scanBoard = scanGridNeon;
+#endif
+}
+
+/**
+ * @brief 评估整个棋盘状态
+ * 
+ * 与棋盘上每个棋子 evaluatePosition() 之和相同，处理器支持时用向量指令整盘扫描。
+ * 
+ * @param b 棋盘
+ * @return int 棋盘状态的评分
+ */
+static int evaluateBoard(const Board *b) {
+    return scanBoard(b);
+}
+
+#ifdef ENGINE_DEBUG
+/**
+ * @brief 核对增量维护的评分，不一致时中止
+ * 
+ * 每条线的得分要与重新计算的结果相同；棋盘总分要与逐点 evaluatePosition() 之和相同，
+ * 逐线计算与向量扫描的结果也要与之相同。
+ * 只在定义 ENGINE_DEBUG 时编译，每步都要扫描整个棋盘，很慢。
+ * 
+ * @param b 棋盘
+ */
+static void verifyBoard(const Board *b) {
+    int score = 0;
+    for (int i = 0; i < BOARD_SIZE; i++) {
+        for (int j = 0; j < BOARD_SIZE; j++) {
+            if (b->board[i][j] == WHITE) {
+                score += evaluatePosition(b, i, j, WHITE);
+            } else if (b->board[i][j] == BLACK) {
+                score -= evaluatePosition(b, i, j, BLACK);
+            }
+        }
+    }
+    if (score != b->boardScore || score != scanLines(b) || score != evaluateBoard(b)) abort();
+
+    for (int d = 0; d < 4; d++) {
+        for (int index = 0; index < LINE_COUNT; index++) {
+            if (b->lineScore[d][index] != evaluateLine(b, d, index)) abort();
+        }
+    }
+}
+#endif
+
+/**
+ * @brief 更新某一行的邻域位集
+ * 
+ * 将该行的棋子向左右各扩展 SEARCH_RANGE 格。
+ * 
+ * @param b 棋盘
+ * @param row 行号
+ */
+static void updateNearRow(Board *b, int row) {
+    uint32_t stones = (uint32_t)b->lineBits[0][0][row] | b->lineBits[1][0][row];
+    uint32_t near = stones;
+    for (int k = 1; k <= SEARCH_RANGE; k++) {
+        near |= (stones << k) | (stones >> k);
+    }
+    b->nearRows[row] = near;
+}
+
+/**
+ * @brief 在空点落子，增量更新棋盘状态并记入悔棋栈
+ * 
+ * @param b 棋盘
+ * @param row 行号
+ * @param col 列号
+ * @param player 落子方
+ */
+static void makeMove(Board *b, int row, int col, int player) {
+    int cell = row * BOARD_SIZE + col;
+    UndoEntry *u = &b->undo[b->stoneCount++];
+    u->cell = (Cell)cell;
+    u->player = (uint8_t)player;
+    u->boardScore = b->boardScore;
+    u->nearRow = b->nearRows[row];
+
+    b->board[row][col] = player;
+    for (int t = 0; t < SYMMETRY_COUNT; t++) {
+        b->symKeys[t] ^= ZOBRIST_CELL(player, symmetryCell[t][cell]);
+    }
+    for (int d = 0; d < 4; d++) {
+        int index = lineIndex(d, row, col);
+        b->lineBits[player - 1][d][index] |= (LineWord)(1u << linePos(d, row, col));
+        u->lineScore[d] = b->lineScore[d][index];
+        b->boardScore -= b->lineScore[d][index];
+        b->lineScore[d][index] = evaluateLine(b, d, index);
+        b->boardScore += b->lineScore[d][index];
+    }
+    updateNearRow(b, row);
+#ifdef ENGINE_DEBUG
+    verifyBoard(b);
+#endif
+}
+
+/**
+ * @brief 撤销最后一次 makeMove()，由悔棋栈恢复棋盘状态
+ * 
+ * @param b 棋盘，至少有一个棋子
+ */
+static void unmakeMove(Board *b) {
+    const UndoEntry *u = &b->undo[--b->stoneCount];
+    int cell = u->cell, player = u->player;
+    int row = cell / BOARD_SIZE, col = cell % BOARD_SIZE;
+
+    b->board[row][col] = EMPTY;
+    for (int t = 0; t < SYMMETRY_COUNT; t++) {
+        b->symKeys[t] ^= ZOBRIST_CELL(player, symmetryCell[t][cell]);
+    }
+    for (int d = 0; d < 4; d++) {
+        int index = lineIndex(d, row, col);
+        b->lineBits[player - 1][d][index] &= (LineWord)~(1u << linePos(d, row, col));
+        b->lineScore[d][index] = u->lineScore[d];
+    }
+    b->boardScore = u->boardScore;
+    b->nearRows[row] = u->nearRow;
+#ifdef ENGINE_DEBUG
+    verifyBoard(b);
+#endif
+}
+
+/**
+ * @brief 取棋盘在对称变换下的规范哈希
+ * 
+ * 八种变换后棋盘的哈希随落子增量维护，取最小者。互为对称的局面得到同一个值。
+ * 走棋方由棋子数决定，不计入哈希。
+ * 
+ * @param b 棋盘
+ * @param transform 输出：取得最小值的变换编号
+ * @return uint64_t 规范哈希
+ */
+static uint64_t canonicalKey(const Board *b, int *transform) {
+    int best = 0;
+    for (int t = 1; t < SYMMETRY_COUNT; t++) {
+        if (b->symKeys[t] < b->symKeys[best]) best = t;
+    }
+    *transform = best;
+    return b->symKeys[best];
+}
+
+/**
+ * @brief 检查棋盘在某个对称变换下是否不变
+ * 
+ * 先比较哈希，相同时再逐格核对。
+ * 
+ * @param b 棋盘
+ * @param t 变换编号
+ * @return int 不变返回1，否则返回0
+ */
+static int isSymmetric(const Board *b, int t) {
+    if (b->symKeys[t] != b->symKeys[0]) return 0;
+    for (int cell = 0; cell < BOARD_SIZE * BOARD_SIZE; cell++) {
+        int image = symmetryCell[t][cell];
+        if (b->board[cell / BOARD_SIZE][cell % BOARD_SIZE] != b->board[image / BOARD_SIZE][image % BOARD_SIZE]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief 按当前的棋型得分重新落一遍所有棋子
+ * 
+ * 棋型得分改变后使用，悔棋栈中保存的得分也随之按新得分计算。
+ * 
+ * @param b 棋盘
+ */
+static void rescoreBoard(Board *b) {
+    UndoEntry stones[BOARD_SIZE * BOARD_SIZE];
+    int count = b->stoneCount;
+    memcpy(stones, b->undo, sizeof(UndoEntry) * count);
+    initBoard(b, b->weights);
+    for (int k = 0; k < count; k++) {
+        makeMove(b, stones[k].cell / BOARD_SIZE, stones[k].cell % BOARD_SIZE, stones[k].player);
+    }
+}
+
+/**
+ * @brief 去掉互为对称的着法
+ * 
+ * 局面在某些对称变换下不变时（多见于开局），互为对称的着法结果相同，
+ * 只保留排在最前面的一个。局面不对称时原样返回。
+ * 
+ * @param b 棋盘
+ * @param moves 着法数组，原地压缩
+ * @param count 着法数
+ * @return int 去重后的着法数
+ */
+static int dropSymmetricMoves(const Board *b, Move *moves, int count) {
+    int symmetries[SYMMETRY_COUNT];
+    int symmetryCount = 0;
+    for (int t = 1; t < SYMMETRY_COUNT; t++) {
+        if (isSymmetric(b, t)) symmetries[symmetryCount++] = t;
+    }
+    if (symmetryCount == 0) return count;
+
+    unsigned char kept[BOARD_SIZE * BOARD_SIZE] = {0};
+    int n = 0;
+    for (int k = 0; k < count; k++) {
+        int cell = moves[k].row * BOARD_SIZE + moves[k].col;
+        int duplicate = 0;
+        for (int s = 0; s < symmetryCount && !duplicate; s++) {
+            duplicate = kept[symmetryCell[symmetries[s]][cell]];
+        }
+        if (!duplicate) {
+            kept[cell] = 1;
+            moves[n++] = moves[k];
+        }
+    }
+    return n;
+}
+
+/**
+ * @brief 生成候选落子点
+ * 
+ * 按行列顺序列出所有空且 SEARCH_RANGE 范围内有棋子的点。每行的候选位集由上下
+ * SEARCH_RANGE 行的邻域位集合并后去掉已有棋子的格子得到，只遍历其中为1的位。
+ * 
+ * @param b 棋盘
+ * @param moves 输出的候选点数组，至少能容纳 BOARD_SIZE * BOARD_SIZE 个
+ * @return int 候选点数量
+ */
+static int generateMoves(const Board *b, Move *moves) {
+    int count = 0;
+    for (int i = 0; i < BOARD_SIZE; i++) {
+        uint32_t near = 0;
+        for (int k = i - SEARCH_RANGE; k <= i + SEARCH_RANGE; k++) {
+            if (k >= 0 && k < BOARD_SIZE) near |= b->nearRows[k];
+        }
+        uint32_t bits = near & LINE_EMPTY(b, 0, i);
+        while (bits) {
+            int j = __builtin_ctz(bits);
+            bits &= bits - 1;
+            moves[count].row = i;
+            moves[count].col = j;
+            count++;
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief splitmix64 伪随机数生成器
+ * 
+ * @param state 生成器状态，每次调用后更新
+ * @return uint64_t 64位随机数
+ */
+static uint64_t splitmix64(uint64_t *state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * @brief 初始化 Zobrist 随机键
+ * 
+ * 使用固定种子的 splitmix64 生成，保证同一局面在每次运行中哈希值相同。
+ */
+static void initZobrist(void) {
+    // 各尺寸的种子不同，开局库中别的尺寸的局面不会被误认
+    uint64_t seed = 0x9E3779B97F4A7C15ULL + (uint64_t)(BOARD_SIZE - ENGINE_DEFAULT_SIZE);
+    for (int p = 0; p < 2; p++) {
+        for (int i = 0; i < BOARD_SIZE; i++) {
+            for (int j = 0; j < BOARD_SIZE; j++) {
+                zobrist[p][i][j] = splitmix64(&seed);
+            }
+        }
+    }
+    zobristSide = splitmix64(&seed);
+}
+
+/**
+ * @brief 按内存预算分配置换表
+ * 
+ * 桶数取不超过预算的最大2的幂，原有内容全部丢弃。
+ * 限定内存的引擎不重新分配，放不下时桶数取内存块中能放下的数目。
+ * 
+ * @param e 引擎
+ * @param megabytes 内存预算（MB）
+ * @return int 成功返回0，失败返回-1
+ */
+static int ttResize(Engine *e, size_t megabytes) {
+    size_t buckets = 1;
+    while (buckets * 2 * sizeof(TTBucket) <= megabytes * 1024 * 1024) {
+        buckets *= 2;
+    }
+
+    if (e->arenaBytes > 0) {
+        if (buckets > e->ttCapacity) {
+            buckets = e->ttCapacity;
+        }
+        memset(e->ttTable, 0, buckets * sizeof(TTBucket));
+        e->ttBuckets = buckets;
+        e->ttMegabytes = megabytes;
+        e->ttClears = 0;
+        return 0;
+    }
+
+    TTBucket *table = calloc(buckets, sizeof(TTBucket));
+    if (table == NULL) {
+        return -1;
+    }
+    free(e->ttTable);
+    e->ttTable = table;
+    e->ttBuckets = buckets;
+    e->ttMegabytes = megabytes;
+    e->ttClears = 0;
+    return 0;
+}
+
+/**
+ * @brief 取局面在置换表中的桶
+ * 
+ * 桶数为2的幂时取哈希的低位；否则把哈希的高32位按桶数等比缩放，不用除法。
+ * 
+ * @param e 引擎
+ * @param key 局面哈希值
+ * @return TTBucket* 桶
+ */
+static inline TTBucket *ttBucket(const Engine *e, uint64_t key) {
+    size_t buckets = e->ttBuckets;
+    if ((buckets & (buckets - 1)) == 0) {
+        return &e->ttTable[key & (buckets - 1)];
+    }
+    return &e->ttTable[(size_t)(((key >> 32) * buckets) >> 32)];
+}
+
+/**
+ * @brief 清空置换表
+ * 
+ * 只换一个代号，原有的项随即全部当作空项，与清零后的查找、替换结果完全相同。
+ * 上次清零以来写入的项的代号各不相同，用完 TT_GENERATIONS 个代号之前才需要真正清零一次，
+ * 这样逐个局面清空置换表再搜索（如批量分析）不必每次都写一遍整张表。
+ * 
+ * @param e 引擎
+ */
+static void ttClear(Engine *e) {
+    if (++e->ttClears < TT_GENERATIONS) {
+        e->ttGeneration = (e->ttGeneration + 1) % TT_GENERATIONS;
+    } else {
+        memset(e->ttTable, 0, e->ttBuckets * sizeof(TTBucket));
+        e->ttClears = 0;
+    }
+    e->ttAge = 0;
+}
+
+/**
+ * @brief 查找置换表
+ * 
+ * @param e 引擎
+ * @param key 局面哈希值
+ * @param depth 输出：保存时的搜索深度
+ * @param score 输出：保存的评分
+ * @param flag 输出：评分类型（TT_EXACT/TT_LOWER/TT_UPPER）
+ * @param move 输出：最佳着法编码（row * BOARD_SIZE + col），无则为 TT_NO_MOVE
+ * @return int 找到返回1，否则返回0
+ */
+static int ttProbe(const Engine *e, uint64_t key, int *depth, score_t *score, int *flag, int *move) {
+    TTBucket *bucket = ttBucket(e, key);
+    for (int k = 0; k < TT_BUCKET_SIZE; k++) {
+        TTEntry *entry = &bucket->entry[k];
+        uint64_t data = entry->data;
+        if ((entry->key ^ data) == key && TT_LIVE(e, data)) {
+            *score = (score_t)(uint32_t)data;
+            *move = (int)((data >> 32) & TT_MOVE_MASK);
+            if (*move == TT_MOVE_MASK) *move = TT_NO_MOVE;
+            *depth = (int)((data >> 48) & 0xFF);
+            *flag = TT_FLAG(data);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief 写入置换表
+ * 
+ * 同一局面直接覆盖；否则替换桶内最旧、深度最浅的一项。
+ * 
+ * @param e 引擎
+ * @param key 局面哈希值
+ * @param depth 搜索深度
+ * @param score 评分
+ * @param flag 评分类型
+ * @param move 最佳着法编码
+ */
+static void ttStore(Engine *e, uint64_t key, int depth, score_t score, int flag, int move) {
+    TTBucket *bucket = ttBucket(e, key);
+    TTEntry *victim = &bucket->entry[0];
+    int victimValue = INT_MAX;
+
+    for (int k = 0; k < TT_BUCKET_SIZE; k++) {
+        TTEntry *entry = &bucket->entry[k];
+        uint64_t data = entry->data;
+        if ((entry->key ^ data) == key || !TT_LIVE(e, data)) {
+            victim = entry;
+            break;
+        }
+        // 本轮写入的条目优先保留，其次保留深度大的
+        int value = (int)((data >> 48) & 0xFF) + (TT_AGE(data) == e->ttAge ? 256 : 0);
+        if (value < victimValue) {
+            victimValue = value;
+            victim = entry;
+        }
+    }
+
+    uint64_t data = (uint64_t)(uint32_t)score
+                  | ((uint64_t)(move & TT_MOVE_MASK) << 32)
+                  | ((uint64_t)e->ttGeneration << 42)
+                  | ((uint64_t)(depth & 0xFF) << 48)
+                  | ((uint64_t)flag << 56)
+                  | ((uint64_t)(e->ttAge & 0x3F) << 58);
+    victim->key = key ^ data;
+    victim->data = data;
+}
+
+/**
+ * @brief 取单调时钟的当前时间
+ * 
+ * @return long long 毫秒数
+ */
+static long long currentTimeMs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ * @brief 给候选着法打排序分
+ * 
+ * @param t 搜索线程
+ * @param moves 候选着法
+ * @param count 着法数量
+ * @param player 走棋方
+ * @param ply 距根节点的层数
+ * @param hashMove 置换表中的最佳着法编码，无则为 TT_NO_MOVE
+ */
+static void scoreMoves(const SearchThread *t, Move *moves, int count, int player, int ply, int hashMove) {
+    const Board *b = &t->board;
+    int opponent = player == WHITE ? BLACK : WHITE;
+    for (int k = 0; k < count; k++) {
+        int i = moves[k].row, j = moves[k].col;
+        // 进攻和防守价值都算上：己方在此成型，或破坏对方在此成型
+        int pattern = evaluatePosition(b, i, j, player) + evaluatePosition(b, i, j, opponent);
+        int score;
+        if (i * BOARD_SIZE + j == hashMove) {
+            score = ORDER_HASH;
+        } else if (isWinningMove(b, i, j, player)) {
+            score = ORDER_WIN;
+        } else if (isWinningMove(b, i, j, opponent)) {
+            score = ORDER_BLOCK;
+        } else if ((t->killers[ply][0].row == i && t->killers[ply][0].col == j) ||
+                   (t->killers[ply][1].row == i && t->killers[ply][1].col == j)) {
+            score = ORDER_KILLER;
+        } else {
+            score = t->history[player - 1][i * BOARD_SIZE + j] + pattern;
+        }
+        moves[k].score = score;
+        moves[k].pattern = pattern;
+    }
+}
+
+/**
+ * @brief 把第 k 个及之后着法中分数最高的一个换到第 k 位
+ * 
+ * 多数节点只试前几个着法就截断，逐个选取比整体排序更省。
+ * 
+ * @param moves 候选着法
+ * @param count 着法数量
+ * @param k 当前位置
+ */
+static void pickMove(Move *moves, int count, int k) {
+    int best = k;
+    for (int m = k + 1; m < count; m++) {
+        if (moves[m].score > moves[best].score) best = m;
+    }
+    if (best != k) {
+        Move tmp = moves[k];
+        moves[k] = moves[best];
+        moves[best] = tmp;
+    }
+}
+
+/**
+ * @brief 记录引起 beta 截断的着法
+ * 
+ * 成五和防守成五之类的着法排序时本来就靠前，不计入杀手和历史表。
+ * 
+ * @param t 搜索线程
+ * @param move 截断着法
+ * @param player 走棋方
+ * @param depth 剩余深度
+ * @param ply 距根节点的层数
+ */
+static void recordCutoff(SearchThread *t, const Move *move, int player, int depth, int ply) {
+    if (move->score >= ORDER_BLOCK) return;
+
+    if (t->killers[ply][0].row != move->row || t->killers[ply][0].col != move->col) {
+        t->killers[ply][1] = t->killers[ply][0];
+        t->killers[ply][0] = *move;
+    }
+
+    int *h = &t->history[player - 1][move->row * BOARD_SIZE + move->col];
+    *h += depth * depth;
+    if (*h > HISTORY_MAX) {
+        for (int p = 0; p < 2; p++) {
+            for (int m = 0; m < BOARD_SIZE * BOARD_SIZE; m++) t->history[p][m] /= 2;
+        }
+    }
+}
+
+/**
+ * @brief 新一步搜索前重置排序信息
+ * 
+ * 杀手着法只对上一步的局面有意义，直接清空；历史得分减半后保留。
+ * 
+ * @param t 搜索线程
+ */
+static void resetOrdering(SearchThread *t) {
+    for (int ply = 0; ply < MAX_DEPTH; ply++) {
+        t->killers[ply][0].row = t->killers[ply][1].row = -1;
+        t->killers[ply][0].col = t->killers[ply][1].col = -1;
+    }
+    for (int p = 0; p < 2; p++) {
+        for (int m = 0; m < BOARD_SIZE * BOARD_SIZE; m++) t->history[p][m] /= 2;
+    }
+}
+
+/**
+ * @brief 把必胜评分换算成相对当前节点的步数，以便存入置换表
+ * 
+ * 同一局面可能在不同层出现，置换表中的必胜评分按距该局面的步数保存。
+ * 
+ * @param score 相对根节点的评分
+ * @param ply 距根节点的层数
+ * @return score_t 存入置换表的评分
+ */
+static score_t scoreToTT(score_t score, int ply) {
+    if (score >= WIN_BOUND) return score + ply;
+    if (score <= -WIN_BOUND) return score - ply;
+    return score;
+}
+
+/**
+ * @brief scoreToTT() 的逆运算：把置换表中的评分换算回相对根节点
+ * 
+ * @param score 置换表中的评分
+ * @param ply 距根节点的层数
+ * @return score_t 相对根节点的评分
+ */
+static score_t scoreFromTT(score_t score, int ply) {
+    if (score >= WIN_BOUND) return score - ply;
+    if (score <= -WIN_BOUND) return score + ply;
+    return score;
+}
+
+/**
+ * @brief 负极大值形式的主变例搜索（PVS）
+ * 
+ * 评分总是从走棋方看。排序最靠前的着法用完整窗口搜索，其余着法先用零窗口
+ * 证明不比已有的好，只有超出 alpha 时才用完整窗口重新搜索。
+ * 
+ * @param t 搜索线程，在其棋盘副本上搜索
+ * @param depth 剩余搜索深度
+ * @param ply 距根节点的层数
+ * @param alpha Alpha值
+ * @param beta Beta值
+ * @param player 走棋方
+ * @return int 从走棋方看的最佳评分
+ */
+static score_t negamax(SearchThread *t, int depth, int ply, score_t alpha, score_t beta, int player) {
+    Board *b = &t->board;
+    Engine *e = t->engine;
+
+    // 超时后放弃本轮搜索，结果由调用方丢弃
+    t->nodes++;
+    if (e->deadline && (t->nodes % SEARCH_CHECK_NODES) == 0 && currentTimeMs() >= e->deadline) {
+        e->stopped = 1;
+    }
+    if (e->stopped) {
+        return 0;
+    }
+
+    if (depth == 0 || depth >= MAX_DEPTH) {
+        STAT_ADD(t, evaluations);
+        // 增量维护的评分，等价于 evaluateBoard()，以白方为正
+        return scoreFromEval(player == WHITE ? b->boardScore : -b->boardScore);
+    }
+
+    // 己方能成五就是终局；对方有两个成五点时挡不住，下一步必败
+    int opponent = player == WHITE ? BLACK : WHITE;
+    int forcedRow, forcedCol;
+    if (countWinPoints(b, player, &forcedRow, &forcedCol) > 0) {
+        return scoreWinIn(ply + 1);
+    }
+    int threats = countWinPoints(b, opponent, &forcedRow, &forcedCol);
+    if (threats > 1) {
+        return scoreLossIn(ply + 2);
+    }
+
+    // 查置换表：深度足够时直接使用或收窄窗口
+    uint64_t key = player == WHITE ? b->symKeys[0] : b->symKeys[0] ^ zobristSide;
+    int ttDepth, ttFlag, ttMove = TT_NO_MOVE;
+    score_t ttScore;
+    int ttFound = ttProbe(e, key, &ttDepth, &ttScore, &ttFlag, &ttMove);
+    STAT_ADD(t, ttProbes);
+    if (ttFound) STAT_ADD(t, ttHits);
+    if (ttFound && ttDepth >= depth) {
+        ttScore = scoreFromTT(ttScore, ply);
+        if (ttFlag == TT_EXACT) return ttScore;
+        if (ttFlag == TT_LOWER) alpha = scoreMax(alpha, ttScore);
+        if (ttFlag == TT_UPPER) beta = scoreMin(beta, ttScore);
+        if (alpha >= beta) return ttScore;
+    }
+    score_t alphaOrig = alpha;
+    score_t bestEval = NEG_INF;
+    int bestMove = TT_NO_MOVE;
+
+    // 对方冲四时只有挡住这一手
+    Move moves[BOARD_SIZE * BOARD_SIZE];
+    int moveCount;
+    if (threats == 1) {
+        moves[0].row = forcedRow;
+        moves[0].col = forcedCol;
+        moves[0].score = 0;
+        moveCount = 1;
+    } else {
+        moveCount = generateMoves(b, moves);
+        scoreMoves(t, moves, moveCount, player, ply, ttMove);
+    }
+
+    for (int k = 0; k < moveCount; k++) {
+        pickMove(moves, moveCount, k);
+        int i = moves[k].row, j = moves[k].col;
+        int late = e->lmrMoves > 0 && k >= e->lmrMoves && moves[k].score < ORDER_KILLER;
+        if (late && moves[k].pattern == 0) {
+            continue;  // 排在后面又与双方棋型无关的点，不值得搜索
+        }
+        int reduction = late && depth >= LMR_MIN_DEPTH ? LMR_REDUCTION : 0;
+        score_t eval;
+        makeMove(b, i, j, player);
+        if (k == 0) {
+            eval = -negamax(t, depth - 1, ply + 1, -beta, -alpha, opponent);
+        } else {
+            eval = -negamax(t, depth - 1 - reduction, ply + 1, -alpha - 1, -alpha, opponent);
+            if (reduction > 0 && eval > alpha) {
+                eval = -negamax(t, depth - 1, ply + 1, -alpha - 1, -alpha, opponent);
+            }
+            if (eval > alpha && eval < beta) {
+                eval = -negamax(t, depth - 1, ply + 1, -beta, -alpha, opponent);
+            }
+        }
+        unmakeMove(b);
+        if (e->stopped) return 0;
+        if (eval > bestEval) {
+            bestEval = eval;
+            bestMove = i * BOARD_SIZE + j;
+        }
+        alpha = scoreMax(alpha, eval);
+        if (alpha >= beta) {
+            STAT_CUTOFF(t, k);
+            recordCutoff(t, &moves[k], player, depth, ply);
+            break;
+        }
+    }
+
+    // 存入置换表
+    if (bestEval <= alphaOrig) ttFlag = TT_UPPER;
+    else if (bestEval >= beta) ttFlag = TT_LOWER;
+    else ttFlag = TT_EXACT;
+    ttStore(e, key, depth, scoreToTT(bestEval, ply), ttFlag, bestMove);
+
+    return bestEval;
+}
+
+/**
+ * 根节点并行搜索的共享状态
+ * 
+ * 第一个着法由主线程单独搜出一个可靠的 alpha，其余着法由各线程按顺序领取。
+ */
+typedef struct {
+    pthread_mutex_t lock;
+    Move *moves;
+    int moveCount;
+    int depth;
+    int side;       // 走棋方
+    score_t alpha;  // 根节点的搜索窗口，得分不超过 alpha 或不小于 beta 时只是界
+    score_t beta;
+    int next;       // 下一个待领取的着法
+    score_t bestScore;
+    int bestIndex;  // 最佳着法在 moves 中的下标，同分时取下标小的
+} RootSplit;
+
+typedef struct {
+    RootSplit *split;
+    SearchThread *thread;
+} RootWorker;
+
+/**
+ * @brief 搜索一个根着法并更新共享的最佳结果
+ * 
+ * 以当前最好分数为 alpha 搜索，返回值大于 alpha 时才是精确值，
+ * 因此只有严格更好的分数或同分且下标更小的着法才会替换最佳着法。
+ * 
+ * @param split 共享状态
+ * @param t 搜索线程
+ * @param k 着法下标
+ */
+static void searchRootMove(RootSplit *split, SearchThread *t, int k) {
+    const Move *move = &split->moves[k];
+
+    pthread_mutex_lock(&split->lock);
+    int first = split->bestIndex < 0;
+    score_t alpha = first ? split->alpha : scoreMax(split->alpha, split->bestScore);
+    score_t beta = split->beta;
+    pthread_mutex_unlock(&split->lock);
+    if (alpha >= beta) return;  // 已有着法超出窗口上界，不必再搜
+
+    // 已有最好分数时先用零窗口试探，超出后再求精确值
+    score_t score;
+    int opponent = split->side == WHITE ? BLACK : WHITE;
+    int five = isWinningMove(&t->board, move->row, move->col, split->side);
+    makeMove(&t->board, move->row, move->col, split->side);
+    if (five) {
+        score = scoreWinIn(1);
+    } else if (first) {
+        score = -negamax(t, split->depth - 1, 1, -beta, -alpha, opponent);
+    } else {
+        score = -negamax(t, split->depth - 1, 1, -alpha - 1, -alpha, opponent);
+        if (score > alpha && score < beta && !t->engine->stopped) {
+            score = -negamax(t, split->depth - 1, 1, -beta, -alpha, opponent);
+        }
+    }
+    unmakeMove(&t->board);
+    if (t->engine->stopped) return;
+
+    pthread_mutex_lock(&split->lock);
+    if (split->bestIndex < 0 || score > split->bestScore ||
+        (score == split->bestScore && score > alpha && k < split->bestIndex)) {
+        split->bestScore = score;
+        split->bestIndex = k;
+    }
+    pthread_mutex_unlock(&split->lock);
+}
+
+/**
+ * @brief 工作线程：不断领取根着法直到领完或超时
+ * 
+ * @param arg RootWorker
+ */
+static void rootWorkerTask(void *arg) {
+    RootWorker *worker = arg;
+    RootSplit *split = worker->split;
+
+    while (!worker->thread->engine->stopped) {
+        pthread_mutex_lock(&split->lock);
+        int k = split->next++;
+        pthread_mutex_unlock(&split->lock);
+        if (k >= split->moveCount) break;
+        searchRootMove(split, worker->thread, k);
+    }
+}
+
+/**
+ * @brief 对根节点做一轮固定深度的搜索
+ * 
+ * 已找到的最好分数作为子节点的 alpha，得分不超过它的着法不会被选中，
+ * 因此结果与每个着法都用完整窗口搜索相同。多线程时各线程在自己的棋盘副本上
+ * 分头搜索剩余着法，通过置换表共享结果；单线程时按顺序搜索，结果确定。
+ * 
+ * 窗口 (alpha, beta) 之内的得分是精确值；不超过 alpha 时只是上界，
+ * 不小于 beta 时只是下界，此时最佳着法不可靠，须用更宽的窗口重搜。
+ * 
+ * @param e 引擎，第0个搜索线程的棋盘为根局面
+ * @param depth 搜索深度
+ * @param alpha 窗口下界
+ * @param beta 窗口上界
+ * @param bestRow 输出：最佳着法的行号
+ * @param bestCol 输出：最佳着法的列号
+ * @return int 从走棋方看的最佳评分；超时中止时结果无效
+ */
+static score_t searchRoot(Engine *e, int depth, score_t alpha, score_t beta, int *bestRow, int *bestCol) {
+    SearchThread *threads = e->threads;
+    int threadCount = e->threadCount;
+    Board *b = &threads[0].board;
+    uint64_t key = e->toMove == WHITE ? b->symKeys[0] : b->symKeys[0] ^ zobristSide;
+    *bestRow = -1;
+    *bestCol = -1;
+
+    // 上一轮的最佳着法存在置换表里，本轮最先搜索
+    int ttDepth, ttFlag, ttMove = TT_NO_MOVE;
+    score_t ttScore;
+    ttProbe(e, key, &ttDepth, &ttScore, &ttFlag, &ttMove);
+
+    // 能成五时直接成五，对方冲四时只能挡；否则搜索所有候选点
+    Move moves[BOARD_SIZE * BOARD_SIZE];
+    int moveCount;
+    int opponent = e->toMove == WHITE ? BLACK : WHITE;
+    int forcedRow, forcedCol;
+    if (countWinPoints(b, e->toMove, &forcedRow, &forcedCol) > 0 ||
+        countWinPoints(b, opponent, &forcedRow, &forcedCol) == 1) {
+        moves[0].row = forcedRow;
+        moves[0].col = forcedCol;
+        moves[0].score = 0;
+        moveCount = 1;
+    } else {
+        moveCount = generateMoves(b, moves);
+        scoreMoves(&threads[0], moves, moveCount, e->toMove, 0, ttMove);
+        for (int k = 0; k < moveCount; k++) {
+            pickMove(moves, moveCount, k);
+        }
+        moveCount = dropSymmetricMoves(b, moves, moveCount);
+    }
+
+    RootSplit split;
+    pthread_mutex_init(&split.lock, NULL);
+    split.moves = moves;
+    split.moveCount = moveCount;
+    split.depth = depth;
+    split.side = e->toMove;
+    split.alpha = alpha;
+    split.beta = beta;
+    split.next = 1;
+    split.bestScore = NEG_INF;
+    split.bestIndex = -1;
+
+    if (moveCount > 0) {
+        searchRootMove(&split, &threads[0], 0);
+    }
+
+    if (threadCount > 1 && e->pool != NULL) {
+        RootWorker workers[threadCount];
+        for (int n = 1; n < threadCount; n++) {
+            threads[n].board = *b;
+            workers[n].split = &split;
+            workers[n].thread = &threads[n];
+            poolSubmit(e->pool, rootWorkerTask, &workers[n]);
+        }
+        workers[0].split = &split;
+        workers[0].thread = &threads[0];
+        rootWorkerTask(&workers[0]);
+        poolWait(e->pool);
+    } else {
+        for (int k = 1; k < moveCount && !e->stopped; k++) {
+            searchRootMove(&split, &threads[0], k);
+        }
+    }
+    pthread_mutex_destroy(&split.lock);
+
+    if (split.bestIndex >= 0) {
+        *bestRow = moves[split.bestIndex].row;
+        *bestCol = moves[split.bestIndex].col;
+        if (!e->stopped) {
+            int flag = split.bestScore <= alpha ? TT_UPPER : split.bestScore >= beta ? TT_LOWER : TT_EXACT;
+            ttStore(e, key, depth, split.bestScore, flag, *bestRow * BOARD_SIZE + *bestCol);
+        }
+    }
+    return split.bestScore;
+}
+
+/**
+ * @brief 以前两层的得分为中心用窄窗口搜索根节点，超出窗口时放宽重搜
+ * 
+ * 评分随搜索深度的奇偶（最后一步是谁走的）来回摆动，相邻两层常差上千分，
+ * 隔一层的得分才接近，所以窗口以同奇偶的 depth - 2 层得分为中心。
+ * 每次超出窗口，超出的一侧按加倍后的半宽放宽，直到得分落在窗口之内。
+ * 前两层、中心为必胜必败分或 aspiration 为0时用完整窗口。
+ * 
+ * @param e 引擎
+ * @param depth 搜索深度
+ * @param previous depth - 2 层的得分
+ * @param bestRow 输出：最佳着法的行号
+ * @param bestCol 输出：最佳着法的列号
+ * @return int 从走棋方看的最佳评分；超时中止时结果无效
+ */
+static score_t searchAspiration(Engine *e, int depth, score_t previous, int *bestRow, int *bestCol) {
+    if (depth <= 2 || e->aspiration <= 0 || scoreIsDecided(previous)) {
+        return searchRoot(e, depth, NEG_INF, INF, bestRow, bestCol);
+    }
+
+    long delta = e->aspiration;
+    score_t alpha = scoreAdd(previous, -delta), beta = scoreAdd(previous, delta);
+    for (;;) {
+        score_t score = searchRoot(e, depth, alpha, beta, bestRow, bestCol);
+        if (e->stopped || *bestRow < 0) return score;
+        delta *= 2;
+        if (score <= alpha) {
+            alpha = scoreAdd(score, -delta);
+        } else if (score >= beta) {
+            beta = scoreAdd(score, delta);
+        } else {
+            return score;
+        }
+#ifdef ENGINE_STATS
+        e->stats.researches++;
+#endif
+    }
+}
+
+
+// 连续攻击求解：攻方只走冲四、活三，守方只考虑能化解威胁的应着
+#define THREAT_MAX_PLY (ENGINE_MAX_LINE - 1)  // 攻守合计的最大步数
+
+/**
+ * 一次连续攻击求解的状态
+ */
+typedef struct {
+    Board *board;
+    int attacker;                                  // 攻方
+    int vct;                                       // 为1时攻方也可以走活三
+    unsigned long nodes;                           // 已走的节点数
+    unsigned long budget;                          // 节点预算
+    Move pv[THREAT_MAX_PLY + 1][ENGINE_MAX_LINE];  // 每层找到的必胜序列
+    int pvLength[THREAT_MAX_PLY + 1];
+} ThreatSearch;
+
+/**
+ * @brief 冲四点检测：返回落子即可形成四的空位
+ * 
+ * 在每个五格窗口中，若恰有三个己方棋子和两个空位，则两个空位都是冲四点。
+ * 
+ * @param x 己方棋子位
+ * @param e 空位
+ * @return uint32_t 冲四点的位集
+ */
+static inline uint32_t fourPoints(uint32_t x, uint32_t e) {
+    uint32_t points = 0;
+    for (int j = 0; j < 5; j++) {
+        for (int k = j + 1; k < 5; k++) {
+            uint32_t w = (e >> j) & (e >> k);
+            for (int m = 0; m < 5; m++) {
+                if (m != j && m != k) w &= x >> m;
+            }
+            points |= (w << j) | (w << k);
+        }
+    }
+    return points;
+}
+
+/**
+ * @brief 活三点检测：返回落子即可形成活三的空位
+ * 
+ * 在每个六格窗口中，若两端为空，中间四格恰有两个己方棋子和两个空位，
+ * 则中间的两个空位都是活三点。
+ * 
+ * @param x 己方棋子位
+ * @param e 空位
+ * @return uint32_t 活三点的位集
+ */
+static inline uint32_t threePoints(uint32_t x, uint32_t e) {
+    uint32_t ends = e & (e >> 5);
+    uint32_t points = 0;
+    for (int j = 1; j <= 4; j++) {
+        for (int k = j + 1; k <= 4; k++) {
+            uint32_t w = ends & (e >> j) & (e >> k);
+            for (int m = 1; m <= 4; m++) {
+                if (m != j && m != k) w &= x >> m;
+            }
+            points |= (w << j) | (w << k);
+        }
+    }
+    return points;
+}
+
+/**
+ * @brief 找出某方所有的冲四点或活三点
+ * 
+ * @param b 棋盘
+ * @param player 棋子颜色
+ * @param three 为1时找活三点，为0时找冲四点
+ * @param rows 输出：每行的点位集
+ */
+static void threatCells(const Board *b, int player, int three, uint32_t rows[BOARD_SIZE]) {
+    memset(rows, 0, BOARD_SIZE * sizeof(uint32_t));
+    for (int d = 0; d < 4; d++) {
+        for (int index = 0; index < LINE_COUNT; index++) {
+            uint32_t own = LINE_OWN(b, player, d, index);
+            if (__builtin_popcount(own) < 3 - three) continue;
+            uint32_t empty = LINE_EMPTY(b, d, index);
+            uint32_t points = three ? threePoints(own, empty) : fourPoints(own, empty);
+            while (points) {
+                int r, c;
+                lineCell(d, index, __builtin_ctz(points), &r, &c);
+                points &= points - 1;
+                rows[r] |= 1u << c;
+            }
+        }
+    }
+}
+
+/**
+ * @brief 列出能消除某方所有活三的空点
+ * 
+ * 活三只由己方棋子和空位决定，对方落子相当于去掉一个空位。
+ * 能化解的点一定在第一条有活三的线上，逐个检查去掉该空位后
+ * 每条有活三的线是否都不再有成活四点。
+ * 
+ * @param b 棋盘
+ * @param player 有活三的一方
+ * @param moves 输出：化解点
+ * @return int 化解点个数；没有活三时返回-1
+ */
+static int threeDefenses(const Board *b, int player, Move *moves) {
+    int lines[4 * LINE_COUNT][2];
+    int lineCount = 0;
+    for (int d = 0; d < 4; d++) {
+        for (int index = 0; index < LINE_COUNT; index++) {
+            uint32_t own = LINE_OWN(b, player, d, index);
+            if (__builtin_popcount(own) < 3) continue;
+            if (openFourPoints(own, LINE_EMPTY(b, d, index))) {
+                lines[lineCount][0] = d;
+                lines[lineCount][1] = index;
+                lineCount++;
+            }
+        }
+    }
+    if (lineCount == 0) return -1;
+
+    int count = 0;
+    uint32_t cells = LINE_EMPTY(b, lines[0][0], lines[0][1]);
+    while (cells) {
+        int r, c;
+        lineCell(lines[0][0], lines[0][1], __builtin_ctz(cells), &r, &c);
+        cells &= cells - 1;
+
+        int defends = 1;
+        for (int n = 0; n < lineCount && defends; n++) {
+            int d = lines[n][0], index = lines[n][1];
+            uint32_t empty = LINE_EMPTY(b, d, index);
+            if (lineIndex(d, r, c) == index) empty &= ~(1u << linePos(d, r, c));
+            if (openFourPoints(LINE_OWN(b, player, d, index), empty)) defends = 0;
+        }
+        if (defends) {
+            moves[count].row = r;
+            moves[count].col = c;
+            count++;
+        }
+    }
+    return count;
+}
+
+static int threatDefend(ThreatSearch *ts, int ply);
+
+/**
+ * @brief 攻方走棋：是否存在一步威胁使守方无论如何应对都输
+ * 
+ * @param ts 求解状态
+ * @param ply 当前步数
+ * @return int 攻方必胜返回1，否则（包括预算用完）返回0
+ */
+static int threatAttack(ThreatSearch *ts, int ply) {
+    Board *b = ts->board;
+    int attacker = ts->attacker;
+    int defender = attacker == WHITE ? BLACK : WHITE;
+    int r, c;
+
+    ts->pvLength[ply] = 0;
+    // 已有成五点，直接取胜
+    if (countWinPoints(b, attacker, &r, &c) > 0) {
+        ts->pv[ply][0].row = r;
+        ts->pv[ply][0].col = c;
+        ts->pvLength[ply] = 1;
+        return 1;
+    }
+    if (ply + 2 > THREAT_MAX_PLY || ts->nodes >= ts->budget) return 0;
+
+    // 对方有冲四时只能去堵，而且堵的这一步本身也必须是威胁
+    int blocks = countWinPoints(b, defender, &r, &c);
+    if (blocks >= 2) return 0;
+
+    // 先试冲四，再试活三
+    uint32_t tried[BOARD_SIZE] = {0};
+    for (int three = 0; three <= ts->vct; three++) {
+        uint32_t rows[BOARD_SIZE];
+        threatCells(b, attacker, three, rows);
+        for (int i = 0; i < BOARD_SIZE; i++) {
+            uint32_t bits = rows[i] & ~tried[i];
+            if (blocks) bits &= i == r ? 1u << c : 0;
+            tried[i] |= bits;
+            while (bits) {
+                int j = __builtin_ctz(bits);
+                bits &= bits - 1;
+
+                ts->nodes++;
+                makeMove(b, i, j, attacker);
+                int win = threatDefend(ts, ply + 1);
+                unmakeMove(b);
+                if (win) {
+                    ts->pv[ply][0].row = i;
+                    ts->pv[ply][0].col = j;
+                    memcpy(&ts->pv[ply][1], ts->pv[ply + 1], ts->pvLength[ply + 1] * sizeof(Move));
+                    ts->pvLength[ply] = ts->pvLength[ply + 1] + 1;
+                    return 1;
+                }
+                if (ts->nodes >= ts->budget) return 0;
+            }
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief 守方应对：是否所有能化解威胁的应着都输
+ * 
+ * 攻方冲四时只能堵成五点；攻方活三时，应着包括所有能消除攻方活三的点，
+ * 以及守方自己的冲四。
+ * 
+ * @param ts 求解状态
+ * @param ply 当前步数
+ * @return int 攻方必胜返回1，否则返回0
+ */
+static int threatDefend(ThreatSearch *ts, int ply) {
+    Board *b = ts->board;
+    int attacker = ts->attacker;
+    int defender = attacker == WHITE ? BLACK : WHITE;
+    int r, c;
+
+    ts->pvLength[ply] = 0;
+    // 守方已有成五点，先胜
+    if (countWinPoints(b, defender, &r, &c) > 0) return 0;
+
+    Move moves[BOARD_SIZE * BOARD_SIZE];
+    int moveCount;
+    int fours = countWinPoints(b, attacker, &r, &c);
+    if (fours >= 2) return 1;  // 双冲四或活四，堵不住
+    if (fours == 1) {
+        moves[0].row = r;
+        moves[0].col = c;
+        moveCount = 1;
+    } else {
+        moveCount = threeDefenses(b, attacker, moves);
+        if (moveCount < 0) return 0;
+
+        // 守方也可以先冲四，争得先手
+        uint32_t rows[BOARD_SIZE];
+        threatCells(b, defender, 0, rows);
+        for (int n = 0; n < moveCount; n++) {
+            rows[moves[n].row] &= ~(1u << moves[n].col);
+        }
+        for (int i = 0; i < BOARD_SIZE; i++) {
+            uint32_t bits = rows[i];
+            while (bits) {
+                moves[moveCount].row = i;
+                moves[moveCount].col = __builtin_ctz(bits);
+                moveCount++;
+                bits &= bits - 1;
+            }
+        }
+    }
+
+    // 每一种应着攻方都要能赢；序列中记录第一种应着之后的变化
+    for (int k = 0; k < moveCount; k++) {
+        int i = moves[k].row, j = moves[k].col;
+        ts->nodes++;
+        makeMove(b, i, j, defender);
+        int win = threatAttack(ts, ply + 1);
+        unmakeMove(b);
+        if (!win) return 0;
+        if (k == 0) {
+            ts->pv[ply][0] = moves[k];
+            memcpy(&ts->pv[ply][1], ts->pv[ply + 1], ts->pvLength[ply + 1] * sizeof(Move));
+            ts->pvLength[ply] = ts->pvLength[ply + 1] + 1;
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief 为走棋方求解连续攻击序列
+ * 
+ * @param b 棋盘，求解过程中会临时落子，返回时恢复原状
+ * @param player 走棋方
+ * @param vct 为1时求解 VCT，为0时只求解 VCF
+ * @param budget 节点预算
+ * @param line 输出：必胜序列
+ * @return int 找到必胜返回1，否则返回0
+ */
+static int solveThreats(Board *b, int player, int vct, unsigned long budget, engine_line_t *line) {
+    ThreatSearch ts;
+    ts.board = b;
+    ts.attacker = player;
+    ts.vct = vct;
+    ts.nodes = 0;
+    ts.budget = budget;
+
+    int win = threatAttack(&ts, 0);
+    line->length = win ? ts.pvLength[0] : 0;
+    for (int k = 0; k < line->length; k++) {
+        line->row[k] = ts.pv[0][k].row;
+        line->col[k] = ts.pv[0][k].col;
+    }
+    line->nodes = ts.nodes;
+    return win;
+}
+
+/**
+ * @brief 生成所有引擎共用的只读表
+ */
+static void initTables(void) {
+    initLineMasks();
+    initSymmetry();
+    initPatterns();
+    selectScanBoard();
+    initZobrist();
+}
+
+/**
+ * @brief 按线程数重新分配搜索线程和线程池
+ * 
+ * @param e 引擎
+ * @param count 线程数
+ * @return int 成功返回0，失败返回-1（原设置不变）
+ */
+static int resizeThreads(Engine *e, int count) {
+    SearchThread *threads = calloc(count, sizeof(SearchThread));
+    if (threads == NULL) {
+        return -1;
+    }
+    // 调用线程自己也参与搜索，线程池只需 count - 1 个工作线程
+    ThreadPool *pool = NULL;
+    if (count > 1) {
+        pool = poolCreate(count - 1, count - 1);
+        if (pool == NULL) {
+            free(threads);
+            return -1;
+        }
+    }
+    for (int n = 0; n < count; n++) {
+        threads[n].engine = e;
+    }
+
+    if (e->pool != NULL) {
+        poolDestroy(e->pool);
+    }
+    free(e->threads);
+    e->threads = threads;
+    e->threadCount = count;
+    e->pool = pool;
+    return 0;
+}
+
+/**
+ * @brief 开始一次迭代加深搜索前的准备
+ * 
+ * 置换表换代，清除停止标志和截止时间，重置各线程的计数和排序信息，
+ * 第0个搜索线程的棋盘取对局棋盘。
+ * 
+ * @param e 引擎
+ */
+static void prepareSearch(Engine *e) {
+    e->ttAge = (e->ttAge + 1) & 0x3F;
+    e->stopped = 0;
+    e->deadline = 0;
+    for (int n = 0; n < e->threadCount; n++) {
+        e->threads[n].nodes = 0;
+#ifdef ENGINE_STATS
+        memset(&e->threads[n].stats, 0, sizeof(e->threads[n].stats));
+#endif
+        resetOrdering(&e->threads[n]);
+    }
+    e->threads[0].board = e->board;
+}
+
+/**
+ * @brief 后台思考线程：为轮到的一方不限时地逐层加深，直到被叫停或到最大深度
+ * 
+ * 轮到的是对方，搜索遍及对方所有可能的应着和己方随后的应对，
+ * 结果都留在置换表中，对方落子后的搜索因此可以直接用上。
+ * 
+ * @param arg 引擎
+ * @return void* 总是 NULL
+ */
+static void *ponderTask(void *arg) {
+    Engine *e = arg;
+    score_t scores[MAX_DEPTH];
+    for (int depth = 1; depth < MAX_DEPTH; depth++) {
+        int r, c;
+        scores[depth] = searchAspiration(e, depth, depth > 2 ? scores[depth - 2] : 0, &r, &c);
+        if (e->stopped || r < 0) break;
+        e->ponderDepth = depth;
+    }
+    return NULL;
+}
+
+/**
+ * @brief 叫停后台思考并等待线程退出，没有在思考时什么也不做
+ * 
+ * 后台思考使用引擎的搜索线程和置换表，任何改变局面或搜索状态的操作之前都要先调用。
+ * 
+ * @param e 引擎
+ * @return int 后台思考完成的深度，没有在思考时返回0
+ */
+static int stopPondering(Engine *e) {
+    if (!e->pondering) {
+        return 0;
+    }
+    e->stopped = 1;
+    pthread_join(e->ponderThread, NULL);
+    e->pondering = 0;
+    return e->ponderDepth;
+}
+
+static void engineFree(Engine *e) {
+    if (e == NULL) {
+        return;
+    }
+    stopPondering(e);
+    if (e->arenaBytes > 0) {
+        return;  // 搜索线程和置换表都在调用方的内存块中
+    }
+    if (e->pool != NULL) {
+        poolDestroy(e->pool);
+    }
+    free(e->threads);
+    free(e->ttTable);
+    free(e);
+}
+
+static void engineInit(Engine *e) {
+    stopPondering(e);
+    initBoard(&e->board, e->weights);
+    e->toMove = BLACK;
+}
+
+/**
+ * @brief 新引擎的默认搜索设置
+ * 
+ * @param e 引擎
+ */
+static void setDefaults(Engine *e) {
+    e->depth = MEDIUM_DEPTH;
+    e->timeLimitMs = 0;
+    e->threatNodes = ENGINE_DEFAULT_THREAT_NODES;
+    e->aspiration = ENGINE_DEFAULT_ASPIRATION;
+    e->lmrMoves = ENGINE_DEFAULT_LMR_MOVES;
+    memcpy(e->weights, defaultWeights, sizeof(e->weights));
+}
+
+static Engine *engineNew(void) {
+    pthread_once(&tablesOnce, initTables);
+
+    Engine *e = calloc(1, sizeof(Engine));
+    if (e == NULL) {
+        return NULL;
+    }
+    setDefaults(e);
+    if (ttResize(e, ENGINE_DEFAULT_HASH_MB) != 0 || resizeThreads(e, 1) != 0) {
+        engineFree(e);
+        return NULL;
+    }
+    engineInit(e);
+    return e;
+}
+
+// 内存块中各部分的起点按缓存行对齐
+#define ARENA_ALIGN 64
+#define ARENA_ROUND(n) (((n) + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN)
+
+/**
+ * 内存块依次放引擎、一个搜索线程和置换表，置换表占满余下的部分。
+ * 内存块由调用方分配和释放；放不下时不写内存块，原来在块中的实例仍可用。
+ */
+static Engine *engineNewLimited(void *block, size_t bytes) {
+    pthread_once(&tablesOnce, initTables);
+
+    size_t threadsAt = ARENA_ROUND(sizeof(Engine));
+    size_t tableAt = ARENA_ROUND(threadsAt + sizeof(SearchThread));
+    if (bytes < tableAt + sizeof(TTBucket)) {
+        return NULL;
+    }
+    Engine *e = block;
+    memset(e, 0, tableAt);  // 置换表由 ttResize() 清零
+    setDefaults(e);
+    e->arenaBytes = bytes;
+    e->threads = (SearchThread *)((char *)e + threadsAt);
+    e->threads[0].engine = e;
+    e->threadCount = 1;
+    e->ttTable = (TTBucket *)((char *)e + tableAt);
+    // ttBucket() 的缩放要求桶数小于 2^32
+    e->ttCapacity = (bytes - tableAt) / sizeof(TTBucket);
+    if (e->ttCapacity > 0xFFFFFFFFu) {
+        e->ttCapacity = 0xFFFFFFFFu;
+    }
+    ttResize(e, (bytes + 1024 * 1024 - 1) / (1024 * 1024));
+    engineInit(e);
+    return e;
+}
+
+static int engineMakeMove(Engine *e, int row, int col) {
+    stopPondering(e);
+    if (row < 0 || row >= BOARD_SIZE || col < 0 || col >= BOARD_SIZE || e->board.board[row][col] != EMPTY) {
+        return -1;
+    }
+    makeMove(&e->board, row, col, e->toMove);
+    e->toMove = e->toMove == BLACK ? WHITE : BLACK;
+    return 0;
+}
+
+static int engineUndo(Engine *e) {
+    stopPondering(e);
+    if (e->board.stoneCount == 0) {
+        return -1;
+    }
+    unmakeMove(&e->board);
+    e->toMove = e->toMove == BLACK ? WHITE : BLACK;
+    return 0;
+}
+
+/**
+ * 从深度1开始逐层加深，限时模式下时间用完时采用最后一轮完整搜索的结果。
+ */
+static int engineSearch(Engine *e, engine_result_t *result) {
+    stopPondering(e);
+    result->forced.length = 0;
+    result->forced.nodes = 0;
+    result->fromBook = 0;
+#ifdef ENGINE_STATS
+    memset(&e->stats, 0, sizeof(e->stats));
+#endif
+
+    // 开局库中的局面直接走库中的着法
+    if (e->book != NULL) {
+        int t, r, c;
+        int move = bookProbe(e->book, canonicalKey(&e->board, &t));
+        if (move >= 0 && move < BOARD_SIZE * BOARD_SIZE) {
+            inverseCell(t, move / BOARD_SIZE, move % BOARD_SIZE, &r, &c);
+            if (e->board.board[r][c] == EMPTY) {
+                result->row = r;
+                result->col = c;
+                result->score = 0;
+                result->depth = 0;
+                result->nodes = 0;
+                result->timeMs = 0;
+                result->fromBook = 1;
+                return 0;
+            }
+        }
+    }
+
+    // 空棋盘没有候选着法，直接下天元
+    if (e->board.stoneCount == 0) {
+        result->row = BOARD_SIZE / 2;
+        result->col = BOARD_SIZE / 2;
+        result->score = 0;
+        result->depth = 0;
+        result->nodes = 0;
+        result->timeMs = 0;
+        return 0;
+    }
+
+    // 先找连续冲四，再找连续做杀，找到必胜就不必做完整的搜索
+    long long start = currentTimeMs();
+    if (e->threatNodes > 0) {
+        e->threads[0].board = e->board;
+        for (int mode = ENGINE_VCF; mode <= ENGINE_VCT; mode++) {
+            if (solveThreats(&e->threads[0].board, e->toMove, mode, e->threatNodes, &result->forced)) {
+                result->row = result->forced.row[0];
+                result->col = result->forced.col[0];
+                result->score = scoreWinIn(result->forced.length);
+                result->depth = 0;
+                result->nodes = result->forced.nodes;
+                result->timeMs = currentTimeMs() - start;
+#ifdef ENGINE_STATS
+                e->stats.threatNodes = result->forced.nodes;
+#endif
+                return 0;
+            }
+        }
+    }
+
+    int bestRow = -1, bestCol = -1, bestDepth = 0;
+    score_t bestScore = 0;
+    score_t scores[MAX_DEPTH];  // 各层的得分，同奇偶的上上层得分作为窗口中心
+    prepareSearch(e);
+
+    // 固定深度时也逐层加深：浅层结果留在置换表和历史表中，用于深层的着法排序
+    int maxDepth = e->timeLimitMs > 0 ? MAX_DEPTH - 1 : e->depth;
+    for (int depth = 1; depth <= maxDepth; depth++) {
+        int r, c;
+        score_t score = searchAspiration(e, depth, depth > 2 ? scores[depth - 2] : 0, &r, &c);
+        if (e->stopped || r < 0) break;
+        bestRow = r;
+        bestCol = c;
+        bestScore = score;
+        bestDepth = depth;
+        scores[depth] = score;
+#ifdef ENGINE_STATS
+        e->stats.depthMs[depth] = currentTimeMs() - start;
+        e->stats.depthNodes[depth] = result->forced.nodes;
+        for (int n = 0; n < e->threadCount; n++) {
+            e->stats.depthNodes[depth] += e->threads[n].nodes;
+        }
+#endif
+
+        if (e->timeLimitMs > 0) {
+            // 深度1总能完成；之后若已用掉一半时间，下一轮多半来不及完成
+            long long elapsed = currentTimeMs() - start;
+            if (elapsed * 2 >= e->timeLimitMs) break;
+            e->deadline = start + e->timeLimitMs;
+        }
+    }
+
+    result->row = bestRow;
+    result->col = bestCol;
+    result->score = bestScore;
+    result->depth = bestDepth;
+    result->nodes = result->forced.nodes;
+    for (int n = 0; n < e->threadCount; n++) {
+        result->nodes += e->threads[n].nodes;
+    }
+    result->timeMs = currentTimeMs() - start;
+
+#ifdef ENGINE_STATS
+    // 汇总各线程的统计
+    e->stats.nodes = result->nodes - result->forced.nodes;
+    e->stats.threatNodes = result->forced.nodes;
+    e->stats.depths = bestDepth;
+    for (int n = 0; n < e->threadCount; n++) {
+        const SearchStats *ts = &e->threads[n].stats;
+        e->stats.evaluations += ts->evaluations;
+        e->stats.ttProbes += ts->ttProbes;
+        e->stats.ttHits += ts->ttHits;
+        e->stats.cutoffs += ts->cutoffs;
+        for (int k = 0; k < ENGINE_CUTOFF_SLOTS; k++) {
+            e->stats.cutoffsAt[k] += ts->cutoffsAt[k];
+        }
+    }
+#endif
+    return bestRow < 0 ? -1 : 0;
+}
+
+static int enginePonder(Engine *e) {
+    stopPondering(e);
+    if (e->arenaBytes > 0) {
+        return -1;  // 线程栈不在内存上限之内
+    }
+    prepareSearch(e);
+    e->ponderDepth = 0;
+    if (pthread_create(&e->ponderThread, NULL, ponderTask, e) != 0) {
+        return -1;
+    }
+    e->pondering = 1;
+    return 0;
+}
+
+static int engineStopPonder(Engine *e) {
+    return stopPondering(e);
+}
+
+static int engineStats(const Engine *e, engine_stats_t *stats) {
+#ifdef ENGINE_STATS
+    *stats = e->stats;
+    return 0;
+#else
+    (void)e;
+    (void)stats;
+    return -1;
+#endif
+}
+
+static int engineSolve(Engine *e, int mode, engine_line_t *line) {
+    stopPondering(e);
+    Board b = e->board;
+    return solveThreats(&b, e->toMove, mode == ENGINE_VCT, e->threatNodes, line);
+}
+
+static uint64_t engineCanonicalKey(const Engine *e, int *transform) {
+    return canonicalKey(&e->board, transform);
+}
+
+static void engineTransformMove(int transform, int row, int col, int *r, int *c) {
+    transformCell(transform, row, col, r, c);
+}
+
+static void engineInverseMove(int transform, int row, int col, int *r, int *c) {
+    inverseCell(transform, row, col, r, c);
+}
+
+static int engineEvaluate(const Engine *e) {
+    return evaluateBoard(&e->board);
+}
+
+static int engineCheckWin(const Engine *e, int row, int col) {
+    return checkWin(&e->board, row, col);
+}
+
+static int engineStone(const Engine *e, int row, int col) {
+    return e->board.board[row][col];
+}
+
+static int engineToMove(const Engine *e) {
+    return e->toMove;
+}
+
+static int engineMoveCount(const Engine *e) {
+    return e->board.stoneCount;
+}
+
+static int engineLastMove(const Engine *e, int *row, int *col) {
+    if (e->board.stoneCount == 0) {
+        return -1;
+    }
+    int cell = e->board.undo[e->board.stoneCount - 1].cell;
+    *row = cell / BOARD_SIZE;
+    *col = cell % BOARD_SIZE;
+    return 0;
+}
+
+static void engineSetDepth(Engine *e, int depth) {
+    if (depth < 1) depth = 1;
+    if (depth > MAX_DEPTH - 1) depth = MAX_DEPTH - 1;
+    e->depth = depth;
+}
+
+static int engineDepth(const Engine *e) {
+    return e->depth;
+}
+
+static int engineMaxDepth(void) {
+    return MAX_DEPTH - 1;
+}
+
+static void engineSetTimeLimit(Engine *e, int ms) {
+    e->timeLimitMs = ms > 0 ? ms : 0;
+}
+
+static int engineTimeLimit(const Engine *e) {
+    return e->timeLimitMs;
+}
+
+static int engineSetThreads(Engine *e, int threads) {
+    stopPondering(e);
+    if (threads < 1) {
+        return -1;
+    }
+    if (e->arenaBytes > 0) {
+        return threads == 1 ? 0 : -1;  // 内存块中只有一个搜索线程
+    }
+    return resizeThreads(e, threads);
+}
+
+static int engineThreads(const Engine *e) {
+    return e->threadCount;
+}
+
+static void engineSetThreatNodes(Engine *e, unsigned long nodes) {
+    e->threatNodes = nodes;
+}
+
+static unsigned long engineThreatNodes(const Engine *e) {
+    return e->threatNodes;
+}
+
+static void engineSetAspiration(Engine *e, int window) {
+    e->aspiration = window > 0 ? window : 0;
+}
+
+static int engineAspiration(const Engine *e) {
+    return e->aspiration;
+}
+
+static void engineSetLmrMoves(Engine *e, int moves) {
+    e->lmrMoves = moves > 0 ? moves : 0;
+}
+
+static int engineLmrMoves(const Engine *e) {
+    return e->lmrMoves;
+}
+
+static void engineSetWeights(Engine *e, const int weights[ENGINE_WEIGHT_COUNT]) {
+    stopPondering(e);
+    for (int k = 0; k < ENGINE_WEIGHT_COUNT; k++) {
+        int weight = weights[k] < 0 ? 0 : weights[k];
+        e->weights[k + 1] = weight > ENGINE_MAX_WEIGHT ? ENGINE_MAX_WEIGHT : weight;
+    }
+    rescoreBoard(&e->board);
+    ttClear(e);  // 置换表中的评分按旧的得分算出
+}
+
+static void engineWeights(const Engine *e, int weights[ENGINE_WEIGHT_COUNT]) {
+    for (int k = 0; k < ENGINE_WEIGHT_COUNT; k++) {
+        weights[k] = e->weights[k + 1];
+    }
+}
+
+static void engineSetBook(Engine *e, const Book *book) {
+    e->book = book;
+}
+
+static const Book *engineBook(const Engine *e) {
+    return e->book;
+}
+
+static void engineBookEntry(const Engine *e, int row, int col, BookEntry *entry) {
+    int t, r, c;
+    entry->key = canonicalKey(&e->board, &t);
+    transformCell(t, row, col, &r, &c);
+    entry->move = (uint16_t)(r * BOARD_SIZE + c);
+    entry->weight = 1;
+    entry->reserved = 0;
+}
+
+static int engineSetHashSize(Engine *e, size_t megabytes) {
+    stopPondering(e);
+    return ttResize(e, megabytes);
+}
+
+static size_t engineHashSize(const Engine *e) {
+    return e->ttMegabytes;
+}
+
+static void engineClearHash(Engine *e) {
+    stopPondering(e);
+    ttClear(e);
+}
+
+static void engineMemory(const Engine *e, engine_memory_t *memory) {
+    memory->limit = e->arenaBytes;
+    memory->state = sizeof(Engine) + (size_t)e->threadCount * sizeof(SearchThread);
+    memory->hash = e->ttBuckets * sizeof(TTBucket);
+    memory->total = e->arenaBytes > 0 ? e->arenaBytes : memory->state + memory->hash;
+}
+
+const EngineOps SIZED_NAME(engineOps, BOARD_SIZE) = {
+    BOARD_SIZE,
+    engineNew,
+    engineNewLimited,
+    engineFree,
+    engineInit,
+    engineMakeMove,
+    engineUndo,
+    engineSearch,
+    enginePonder,
+    engineStopPonder,
+    engineStats,
+    engineSolve,
+    engineCanonicalKey,
+    engineTransformMove,
+    engineInverseMove,
+    engineEvaluate,
+    engineCheckWin,
+    engineStone,
+    engineToMove,
+    engineMoveCount,
+    engineLastMove,
+    engineSetDepth,
+    engineDepth,
+    engineMaxDepth,
+    engineSetTimeLimit,
+    engineTimeLimit,
+    engineSetThreads,
+    engineThreads,
+    engineSetThreatNodes,
+    engineThreatNodes,
+    engineSetAspiration,
+    engineAspiration,
+    engineSetLmrMoves,
+    engineLmrMoves,
+    engineSetWeights,
+    engineWeights,
+    engineSetBook,
+    engineBook,
+    engineBookEntry,
+    engineSetHashSize,
+    engineHashSize,
+    engineClearHash,
+    engineMemory,
+};
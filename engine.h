@@ -0,0 +1,504 @@
+/*
+ * 五子棋引擎库 libgobang
+ * 版权所有 (C) 2024 [大龙软件 bigdragonsoft.com]
+ *
+ * 引擎的全部状态（棋盘、置换表、搜索线程等）都保存在 engine_t 中，
+ * 所有调用都显式传入引擎，不同引擎之间没有共享的可变状态，
+ * 一个进程可以同时运行任意多盘对局。同一个引擎不能被多个线程同时调用。
+ * 棋盘可以是 15、19、20 路，每种尺寸都有按该尺寸专门编译的一份实现。
+ *
+ * Gobang engine library libgobang
+ * Copyright (C) 2024 [bigdragonsoft.com]
+ */
+
+#ifndef GOBANG_ENGINE_H
+#define GOBANG_ENGINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "book.h"
+
+#define ENGINE_DEFAULT_SIZE 15  // 默认的棋盘边长
+#define ENGINE_MAX_SIZE 20      // 支持的最大棋盘边长，可用于界面中定长数组的大小
+
+#define EMPTY 0
+#define BLACK 1
+#define WHITE 2
+
+#define EASY_DEPTH 2
+#define MEDIUM_DEPTH 3
+#define HARD_DEPTH 4
+#define EXPERT_DEPTH 6
+
+#define ENGINE_DEFAULT_HASH_MB 1  // 新建引擎的置换表大小（MB）
+
+#define ENGINE_DEFAULT_THREAT_NODES 20000  // 新建引擎每次 VCF/VCT 求解的节点预算
+#define ENGINE_DEFAULT_ASPIRATION 800       // 新建引擎根节点搜索窗口的半宽
+#define ENGINE_DEFAULT_LMR_MOVES 4          // 新建引擎每个节点按完整深度搜索的着法数
+
+#define ENGINE_VCF 0  // 只用冲四（连续冲四取胜）
+#define ENGINE_VCT 1  // 冲四和活三（连续做杀取胜）
+
+#define ENGINE_MAX_LINE 32  // 必胜序列的最大长度
+
+// 评估权重依次为活二、眠三、活三、冲四、活四、五连的得分
+#define ENGINE_WEIGHT_COUNT 6
+#define ENGINE_MAX_WEIGHT 1000000  // 每个得分的上限，超出的按上限计
+
+// 必胜评分：第 n 步成五的得分为 ENGINE_WIN_SCORE - n，必败取负。
+// 静态评分总在 ±ENGINE_WIN_BOUND 之内，超出的只能是必胜或必败
+#define ENGINE_WIN_SCORE (1 << 30)
+#define ENGINE_WIN_BOUND (ENGINE_WIN_SCORE - ENGINE_MAX_SIZE * ENGINE_MAX_SIZE)
+
+#define ENGINE_CUTOFF_SLOTS 8   // 按着法序号统计截断次数的格数
+#define ENGINE_STATS_DEPTHS 16  // 按深度统计用时的格数
+
+typedef struct engine engine_t;
+
+/**
+ * 必胜序列：攻方和守方的着法交替排列，第一步为攻方
+ */
+typedef struct {
+    int length;               // 着法数，0 表示没有找到
+    int row[ENGINE_MAX_LINE];
+    int col[ENGINE_MAX_LINE];
+    unsigned long long nodes; // 求解的节点数
+} engine_line_t;
+
+/**
+ * 一次搜索的结果
+ */
+typedef struct {
+    int row;                  // 最佳着法的行号，无棋可走时为 -1
+    int col;                  // 最佳着法的列号，无棋可走时为 -1
+    int score;                // 从走棋方看的评分，越大越有利；绝对值不小于 ENGINE_WIN_BOUND 时为必胜或必败
+    int depth;                // 完成的搜索深度，由 VCF/VCT 求解得出时为 0
+    unsigned long long nodes; // 搜索的节点数
+    long long timeMs;         // 用时（毫秒）
+    engine_line_t forced;     // 找到必胜时的必胜序列，否则 length 为 0
+    int fromBook;             // 着法取自开局库时为1
+} engine_result_t;
+
+/**
+ * 最近一次 engine_search() 的搜索统计
+ *
+ * 编译库时定义 ENGINE_STATS 才会收集（make STATS=0 时不收集，搜索没有额外开销）。
+ */
+typedef struct {
+    unsigned long long nodes;         // 极小极大搜索的节点数
+    unsigned long long threatNodes;   // VCF/VCT 求解的节点数
+    unsigned long long evaluations;   // 叶节点评估次数
+    unsigned long long researches;    // 得分超出根节点窗口后的重搜次数
+    unsigned long long ttProbes;      // 置换表查找次数
+    unsigned long long ttHits;        // 置换表命中次数
+    unsigned long long cutoffs;       // beta 截断次数
+    unsigned long long cutoffsAt[ENGINE_CUTOFF_SLOTS];  // 由第 k 个着法引起的截断数，最后一格含其后所有着法
+    int depths;                       // 完成的搜索深度
+    long long depthMs[ENGINE_STATS_DEPTHS];  // 做完第 d 层时的累计用时（毫秒），d 从1到 depths
+    unsigned long long depthNodes[ENGINE_STATS_DEPTHS];  // 做完第 d 层时的累计节点数
+} engine_stats_t;
+
+/**
+ * 一个引擎占用的内存（字节）
+ *
+ * 不含多线程搜索和后台思考的线程栈，也不含多个引擎共用的开局库。
+ */
+typedef struct {
+    size_t limit;   // 内存上限，由 engine_new_limited() 创建时为创建时的上限，否则为0
+    size_t total;   // 引擎占用的全部内存，限定内存时等于 limit
+    size_t state;   // 棋盘、悔棋栈、历史表、杀手着法等搜索状态
+    size_t hash;    // 置换表
+} engine_memory_t;
+
+/**
+ * @brief 创建引擎
+ *
+ * 新引擎为 ENGINE_DEFAULT_SIZE 路的空棋盘，中等难度、不限时、单线程，
+ * 置换表 ENGINE_DEFAULT_HASH_MB。
+ *
+ * @return engine_t* 成功返回引擎，内存不足返回 NULL
+ */
+engine_t *engine_new(void);
+
+/**
+ * @brief 创建指定棋盘尺寸的引擎，其余同 engine_new()
+ *
+ * @param size 棋盘边长
+ * @return engine_t* 成功返回引擎，不支持该尺寸或内存不足返回 NULL
+ */
+engine_t *engine_new_size(int size);
+
+/**
+ * @brief 创建内存不超过上限的引擎
+ *
+ * 引擎的全部状态（engine_t 本身、棋盘、悔棋栈、历史表和置换表）在创建时放在一块内存中，
+ * 之后的落子、搜索、改置换表大小都不再分配内存，占用的内存固定为上限。
+ * 置换表占满上限中余下的部分；engine_set_hash_size() 超出上限时取上限内能放下的最大值。
+ * 这样的引擎只在调用线程中单线程搜索，engine_set_threads() 大于1和 engine_ponder() 返回-1；
+ * engine_set_size() 在同一块内存中重建。其余同 engine_new_size()。
+ *
+ * @param size 棋盘边长
+ * @param megabytes 内存上限（MB）
+ * @return engine_t* 成功返回引擎，不支持该尺寸、上限放不下搜索状态或内存不足返回 NULL
+ */
+engine_t *engine_new_limited(int size, size_t megabytes);
+
+/**
+ * @brief 是否支持某种棋盘尺寸
+ *
+ * @param size 棋盘边长
+ * @return int 支持返回1，否则返回0
+ */
+int engine_size_supported(int size);
+
+/**
+ * @brief 改变棋盘尺寸并开始新的一局
+ *
+ * 搜索设置（深度、时间、线程、权重、开局库、置换表大小）保持不变，
+ * 置换表内容丢弃。尺寸不变时只清空棋盘。
+ *
+ * @param e 引擎
+ * @param size 棋盘边长
+ * @return int 成功返回0，不支持该尺寸或内存不足返回-1（引擎不变）
+ */
+int engine_set_size(engine_t *e, int size);
+
+/**
+ * @brief 取棋盘边长
+ */
+int engine_size(const engine_t *e);
+
+/**
+ * @brief 释放引擎及其线程和置换表
+ *
+ * @param e 引擎，可以为 NULL
+ */
+void engine_free(engine_t *e);
+
+/**
+ * @brief 清空棋盘，开始新的一局
+ *
+ * 置换表中的内容仍然有效，予以保留。
+ *
+ * @param e 引擎
+ */
+void engine_init(engine_t *e);
+
+/**
+ * @brief 轮到的一方在指定位置落子
+ *
+ * @param e 引擎
+ * @param row 行号
+ * @param col 列号
+ * @return int 成功返回0，位置非法或已有棋子返回-1
+ */
+int engine_make_move(engine_t *e, int row, int col);
+
+/**
+ * @brief 撤销最后一步棋
+ *
+ * @param e 引擎
+ * @return int 成功返回0，没有可撤销的棋返回-1
+ */
+int engine_undo(engine_t *e);
+
+/**
+ * @brief 为轮到的一方搜索最佳着法
+ *
+ * 局面在开局库中时直接走库中的着法；否则先用 VCF、VCT 求解器寻找
+ * 必胜序列，找到时直接走其第一步；再否则按引擎设置的深度或时间搜索。
+ * 不改变棋盘。
+ *
+ * @param e 引擎
+ * @param result 输出：搜索结果
+ * @return int 找到着法返回0，棋盘已满返回-1
+ */
+int engine_search(engine_t *e, engine_result_t *result);
+
+/**
+ * @brief 在后台为轮到的一方开始思考（通常是在等对方落子时）
+ *
+ * 后台线程不限时地逐层加深搜索当前局面，结果留在置换表中，
+ * 对方落子后的 engine_search() 可以用上。思考期间可以读取局面
+ * （engine_stone()、engine_check_win() 等）；其他改变局面或搜索状态的调用
+ * 会先停止思考。已在思考时重新开始。
+ *
+ * @param e 引擎
+ * @return int 成功返回0，无法创建线程或引擎限定了内存返回-1
+ */
+int engine_ponder(engine_t *e);
+
+/**
+ * @brief 停止后台思考并等待其结束
+ *
+ * @param e 引擎
+ * @return int 后台思考完成的深度，没有在思考时返回0
+ */
+int engine_stop_ponder(engine_t *e);
+
+/**
+ * @brief 取最近一次 engine_search() 的搜索统计
+ *
+ * @param e 引擎
+ * @param stats 输出：搜索统计
+ * @return int 成功返回0，库编译时未收集统计返回-1（stats 不变）
+ */
+int engine_stats(const engine_t *e, engine_stats_t *stats);
+
+/**
+ * @brief 为轮到的一方求解必胜的连续攻击序列
+ *
+ * 只搜索冲四、活三这类对方必须应对的着法，节点数超过 engine_set_threat_nodes()
+ * 设置的预算时放弃。不改变棋盘。
+ *
+ * @param e 引擎
+ * @param mode ENGINE_VCF 或 ENGINE_VCT
+ * @param line 输出：必胜序列
+ * @return int 找到必胜返回1，否则返回0
+ */
+int engine_solve(engine_t *e, int mode, engine_line_t *line);
+
+/**
+ * @brief 取当前局面在八种对称变换下的规范哈希
+ *
+ * 互为旋转或镜像的局面得到同一个值，可以作为各种缓存的键。
+ * 走棋方由棋子数决定，不计入哈希。
+ *
+ * @param e 引擎
+ * @param transform 输出：把当前棋盘变成规范形式的变换编号（0 到 7）
+ * @return uint64_t 规范哈希
+ */
+uint64_t engine_canonical_key(const engine_t *e, int *transform);
+
+/**
+ * @brief 把着法从原棋盘换算到变换后的棋盘
+ *
+ * @param e 引擎，决定棋盘尺寸
+ * @param transform 变换编号，由 engine_canonical_key() 得到
+ * @param row 行号
+ * @param col 列号
+ * @param r 输出：变换后的行号
+ * @param c 输出：变换后的列号
+ */
+void engine_transform_move(const engine_t *e, int transform, int row, int col, int *r, int *c);
+
+/**
+ * @brief engine_transform_move() 的逆变换：把规范形式下的着法换算回原棋盘
+ */
+void engine_inverse_move(const engine_t *e, int transform, int row, int col, int *r, int *c);
+
+/**
+ * @brief 当前局面的静态评分
+ *
+ * @param e 引擎
+ * @return int 评分，白方有利为正，黑方有利为负
+ */
+int engine_evaluate(const engine_t *e);
+
+/**
+ * @brief 检查某点的棋子是否构成五连
+ *
+ * @param e 引擎
+ * @param row 行号
+ * @param col 列号
+ * @return int 构成五连返回1，否则返回0
+ */
+int engine_check_win(const engine_t *e, int row, int col);
+
+/**
+ * @brief 取某点的棋子
+ *
+ * @return int EMPTY、BLACK 或 WHITE
+ */
+int engine_stone(const engine_t *e, int row, int col);
+
+/**
+ * @brief 取轮到走棋的一方
+ *
+ * @return int BLACK 或 WHITE
+ */
+int engine_to_move(const engine_t *e);
+
+/**
+ * @brief 取已下的棋子数
+ */
+int engine_move_count(const engine_t *e);
+
+/**
+ * @brief 取最后一步棋的位置
+ *
+ * @param e 引擎
+ * @param row 输出：行号
+ * @param col 输出：列号
+ * @return int 成功返回0，棋盘为空返回-1
+ */
+int engine_last_move(const engine_t *e, int *row, int *col);
+
+/**
+ * @brief 设置固定搜索深度（不限时时使用）
+ *
+ * @param e 引擎
+ * @param depth 搜索深度，1 到 engine_max_depth()
+ */
+void engine_set_depth(engine_t *e, int depth);
+
+/**
+ * @brief 取固定搜索深度
+ */
+int engine_depth(const engine_t *e);
+
+/**
+ * @brief 取引擎支持的最大搜索深度
+ */
+int engine_max_depth(void);
+
+/**
+ * @brief 设置每步思考时间
+ *
+ * @param e 引擎
+ * @param ms 毫秒数，0 表示按固定深度搜索
+ */
+void engine_set_time_limit(engine_t *e, int ms);
+
+/**
+ * @brief 取每步思考时间（毫秒），0 表示不限时
+ */
+int engine_time_limit(const engine_t *e);
+
+/**
+ * @brief 设置搜索线程数
+ *
+ * @param e 引擎
+ * @param threads 线程数，1 表示在调用线程中单线程搜索
+ * @return int 成功返回0，失败返回-1（原设置不变）
+ */
+int engine_set_threads(engine_t *e, int threads);
+
+/**
+ * @brief 取搜索线程数
+ */
+int engine_threads(const engine_t *e);
+
+/**
+ * @brief 设置 engine_search() 中 VCF/VCT 求解的节点预算
+ *
+ * @param e 引擎
+ * @param nodes 每次求解的节点数上限，0 表示搜索前不求解
+ */
+void engine_set_threat_nodes(engine_t *e, unsigned long nodes);
+
+/**
+ * @brief 取 VCF/VCT 求解的节点预算
+ */
+unsigned long engine_threat_nodes(const engine_t *e);
+
+/**
+ * @brief 设置根节点的搜索窗口（aspiration window）
+ *
+ * 从第3层起，每层先用以前两层（奇偶相同的一层）得分为中心、半宽为 window 的窄窗口搜索，
+ * 得分超出窗口时把超出的一侧放宽一倍后重搜。窗口越窄截断越多，但重搜也越多。
+ *
+ * @param e 引擎
+ * @param window 窗口半宽（评分单位），0 表示每层都用完整窗口
+ */
+void engine_set_aspiration(engine_t *e, int window);
+
+/**
+ * @brief 取根节点搜索窗口的半宽
+ */
+int engine_aspiration(const engine_t *e);
+
+/**
+ * @brief 设置后期着法削减（LMR）和前向剪枝
+ *
+ * 根节点以下，排序后的前 moves 个着法以及置换表着法、成五、挡五、杀手着法按完整深度搜索；
+ * 其余着法少搜一层，得分超过 alpha 时再按完整深度重搜，
+ * 不成任何棋型也不挡对方棋型的直接不搜。
+ *
+ * @param e 引擎
+ * @param moves 按完整深度搜索的着法数，0 表示所有着法都按完整深度搜索
+ */
+void engine_set_lmr_moves(engine_t *e, int moves);
+
+/**
+ * @brief 取按完整深度搜索的着法数
+ */
+int engine_lmr_moves(const engine_t *e);
+
+/**
+ * @brief 设置评估用的各棋型得分
+ *
+ * 置换表随之清空。得分限制在 0 到 ENGINE_MAX_WEIGHT 之间，
+ * 这样整个棋盘的评分不会溢出。
+ *
+ * @param e 引擎
+ * @param weights ENGINE_WEIGHT_COUNT 个得分，顺序见 ENGINE_WEIGHT_COUNT
+ */
+void engine_set_weights(engine_t *e, const int weights[ENGINE_WEIGHT_COUNT]);
+
+/**
+ * @brief 取评估用的各棋型得分
+ *
+ * @param e 引擎
+ * @param weights 输出：ENGINE_WEIGHT_COUNT 个得分
+ */
+void engine_weights(const engine_t *e, int weights[ENGINE_WEIGHT_COUNT]);
+
+/**
+ * @brief 设置 engine_search() 使用的开局库
+ *
+ * 开局库只读，可以由多个引擎共用，必须在这些引擎释放后才能关闭。
+ *
+ * @param e 引擎
+ * @param book 开局库，NULL 表示不用开局库
+ */
+void engine_set_book(engine_t *e, const Book *book);
+
+/**
+ * @brief 取 engine_search() 使用的开局库，没有时为 NULL
+ */
+const Book *engine_book(const engine_t *e);
+
+/**
+ * @brief 生成当前局面下某个着法的开局库记录
+ *
+ * 局面按棋盘的八种对称变换规范化，着法换算到同一方向，权重为1。
+ *
+ * @param e 引擎
+ * @param row 着法的行号
+ * @param col 着法的列号
+ * @param entry 输出：开局库记录
+ */
+void engine_book_entry(const engine_t *e, int row, int col, BookEntry *entry);
+
+/**
+ * @brief 按内存预算重新分配置换表，原有内容丢弃
+ *
+ * 由 engine_new_limited() 创建的引擎不重新分配，在创建时的上限内取不超过预算的最大值。
+ *
+ * @param e 引擎
+ * @param megabytes 内存预算（MB）
+ * @return int 成功返回0，内存不足返回-1（原置换表不变）
+ */
+int engine_set_hash_size(engine_t *e, size_t megabytes);
+
+/**
+ * @brief 取置换表的内存预算（MB）
+ */
+size_t engine_hash_size(const engine_t *e);
+
+/**
+ * @brief 清空置换表
+ */
+void engine_clear_hash(engine_t *e);
+
+/**
+ * @brief 取引擎当前占用的内存
+ *
+ * @param e 引擎
+ * @param memory 输出：占用的内存
+ */
+void engine_memory(const engine_t *e, engine_memory_t *memory);
+
+#endif
@@ -0,0 +1,330 @@
+/*
+ * 五子棋引擎库 libgobang - 公开接口
+ * 版权所有 (C) 2024 [大龙软件 bigdragonsoft.com]
+ *
+ * engine_t 记录当前棋盘尺寸的函数表和该尺寸的引擎实例，
+ * 每个公开接口都转发给函数表中对应的函数。改变尺寸时换一个实例。
+ * 限定内存的引擎只分配一块内存：engine_t 在块首，实例在其后。
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "engineops.h"
+
+struct engine {
+    const EngineOps *ops;  // 当前棋盘尺寸的函数表
+    Engine *impl;          // 该尺寸的引擎实例
+    size_t bytes;          // 限定内存时整个内存块的大小，否则为0
+};
+
+// 限定内存时实例在内存块中的起点，按缓存行对齐
+#define ENGINE_HEADER ((sizeof(engine_t) + 63) / 64 * 64)
+
+// 编译进库的所有尺寸
+#define ENGINE_OPS_ENTRY(n) &engineOps##n,
+static const EngineOps *const engineSizes[] = { ENGINE_SIZES(ENGINE_OPS_ENTRY) };
+#undef ENGINE_OPS_ENTRY
+
+#define ENGINE_SIZE_COUNT ((int)(sizeof(engineSizes) / sizeof(engineSizes[0])))
+
+/**
+ * @brief 取某个尺寸的函数表
+ * 
+ * @param size 棋盘边长
+ * @return const EngineOps* 函数表，不支持该尺寸时返回 NULL
+ */
+static const EngineOps *findOps(int size) {
+    for (int k = 0; k < ENGINE_SIZE_COUNT; k++) {
+        if (engineSizes[k]->size == size) return engineSizes[k];
+    }
+    return NULL;
+}
+
+engine_t *engine_new(void) {
+    return engine_new_size(ENGINE_DEFAULT_SIZE);
+}
+
+/**
+ * @brief 在限定内存的引擎的内存块中创建某个尺寸的实例
+ * 
+ * @param e 引擎，bytes 为内存块大小
+ * @param ops 该尺寸的函数表
+ * @return Engine* 成功返回实例，内存块放不下返回 NULL（块中原来的实例不受影响）
+ */
+static Engine *createInBlock(engine_t *e, const EngineOps *ops) {
+    return ops->createLimited((char *)e + ENGINE_HEADER, e->bytes - ENGINE_HEADER);
+}
+
+engine_t *engine_new_size(int size) {
+    const EngineOps *ops = findOps(size);
+    if (ops == NULL) {
+        return NULL;
+    }
+    engine_t *e = malloc(sizeof(engine_t));
+    if (e == NULL) {
+        return NULL;
+    }
+    e->ops = ops;
+    e->bytes = 0;
+    e->impl = ops->create();
+    if (e->impl == NULL) {
+        free(e);
+        return NULL;
+    }
+    return e;
+}
+
+engine_t *engine_new_limited(int size, size_t megabytes) {
+    const EngineOps *ops = findOps(size);
+    if (ops == NULL || megabytes == 0 || megabytes > SIZE_MAX / (1024 * 1024)) {
+        return NULL;
+    }
+    size_t bytes = megabytes * 1024 * 1024;
+    engine_t *e = malloc(bytes);
+    if (e == NULL) {
+        return NULL;
+    }
+    e->ops = ops;
+    e->bytes = bytes;
+    e->impl = createInBlock(e, ops);
+    if (e->impl == NULL) {
+        free(e);
+        return NULL;
+    }
+    return e;
+}
+
+int engine_size_supported(int size) {
+    return findOps(size) != NULL;
+}
+
+int engine_set_size(engine_t *e, int size) {
+    const EngineOps *ops = findOps(size);
+    if (ops == NULL) {
+        return -1;
+    }
+    if (ops == e->ops) {
+        ops->init(e->impl);
+        return 0;
+    }
+
+    // 新实例沿用原来的全部搜索设置。限定内存的引擎在同一内存块中重建，
+    // 会覆盖原来的实例，所以先把设置取出来
+    const EngineOps *old = e->ops;
+    int weights[ENGINE_WEIGHT_COUNT];
+    old->weights(e->impl, weights);
+    size_t hashSize = old->hashSize(e->impl);
+    int threads = old->threads(e->impl);
+    int depth = old->depth(e->impl);
+    int timeLimit = old->timeLimit(e->impl);
+    unsigned long threatNodes = old->threatNodes(e->impl);
+    int aspiration = old->aspiration(e->impl);
+    int lmrMoves = old->lmrMoves(e->impl);
+    const Book *book = old->book(e->impl);
+
+    Engine *impl;
+    if (e->bytes > 0) {
+        old->stopPonder(e->impl);
+        impl = createInBlock(e, ops);
+        if (impl == NULL) {
+            return -1;
+        }
+        // 限定内存的引擎改置换表大小不会失败，只有一个线程
+        ops->setHashSize(impl, hashSize);
+    } else {
+        impl = ops->create();
+        if (impl == NULL) {
+            return -1;
+        }
+        if (ops->setHashSize(impl, hashSize) != 0 || ops->setThreads(impl, threads) != 0) {
+            ops->destroy(impl);
+            return -1;
+        }
+        old->destroy(e->impl);
+    }
+    ops->setDepth(impl, depth);
+    ops->setTimeLimit(impl, timeLimit);
+    ops->setThreatNodes(impl, threatNodes);
+    ops->setAspiration(impl, aspiration);
+    ops->setLmrMoves(impl, lmrMoves);
+    ops->setWeights(impl, weights);
+    ops->setBook(impl, book);
+
+    e->ops = ops;
+    e->impl = impl;
+    return 0;
+}
+
+int engine_size(const engine_t *e) {
+    return e->ops->size;
+}
+
+void engine_free(engine_t *e) {
+    if (e == NULL) {
+        return;
+    }
+    e->ops->destroy(e->impl);
+    free(e);
+}
+
+void engine_init(engine_t *e) {
+    e->ops->init(e->impl);
+}
+
+int engine_make_move(engine_t *e, int row, int col) {
+    return e->ops->makeMove(e->impl, row, col);
+}
+
+int engine_undo(engine_t *e) {
+    return e->ops->undo(e->impl);
+}
+
+int engine_search(engine_t *e, engine_result_t *result) {
+    return e->ops->search(e->impl, result);
+}
+
+int engine_ponder(engine_t *e) {
+    return e->ops->ponder(e->impl);
+}
+
+int engine_stop_ponder(engine_t *e) {
+    return e->ops->stopPonder(e->impl);
+}
+
+int engine_stats(const engine_t *e, engine_stats_t *stats) {
+    return e->ops->stats(e->impl, stats);
+}
+
+int engine_solve(engine_t *e, int mode, engine_line_t *line) {
+    return e->ops->solve(e->impl, mode, line);
+}
+
+uint64_t engine_canonical_key(const engine_t *e, int *transform) {
+    return e->ops->canonicalKey(e->impl, transform);
+}
+
+void engine_transform_move(const engine_t *e, int transform, int row, int col, int *r, int *c) {
+    e->ops->transformMove(transform, row, col, r, c);
+}
+
+void engine_inverse_move(const engine_t *e, int transform, int row, int col, int *r, int *c) {
+    e->ops->inverseMove(transform, row, col, r, c);
+}
+
+int engine_evaluate(const engine_t *e) {
+    return e->ops->evaluate(e->impl);
+}
+
+int engine_check_win(const engine_t *e, int row, int col) {
+    return e->ops->checkWin(e->impl, row, col);
+}
+
+int engine_stone(const engine_t *e, int row, int col) {
+    return e->ops->stone(e->impl, row, col);
+}
+
+int engine_to_move(const engine_t *e) {
+    return e->ops->toMove(e->impl);
+}
+
+int engine_move_count(const engine_t *e) {
+    return e->ops->moveCount(e->impl);
+}
+
+int engine_last_move(const engine_t *e, int *row, int *col) {
+    return e->ops->lastMove(e->impl, row, col);
+}
+
+void engine_set_depth(engine_t *e, int depth) {
+    e->ops->setDepth(e->impl, depth);
+}
+
+int engine_depth(const engine_t *e) {
+    return e->ops->depth(e->impl);
+}
+
+int engine_max_depth(void) {
+    return engineSizes[0]->maxDepth();
+}
+
+void engine_set_time_limit(engine_t *e, int ms) {
+    e->ops->setTimeLimit(e->impl, ms);
+}
+
+int engine_time_limit(const engine_t *e) {
+    return e->ops->timeLimit(e->impl);
+}
+
+int engine_set_threads(engine_t *e, int threads) {
+    return e->ops->setThreads(e->impl, threads);
+}
+
+int engine_threads(const engine_t *e) {
+    return e->ops->threads(e->impl);
+}
+
+void engine_set_threat_nodes(engine_t *e, unsigned long nodes) {
+    e->ops->setThreatNodes(e->impl, nodes);
+}
+
+unsigned long engine_threat_nodes(const engine_t *e) {
+    return e->ops->threatNodes(e->impl);
+}
+
+void engine_set_aspiration(engine_t *e, int window) {
+    e->ops->setAspiration(e->impl, window);
+}
+
+int engine_aspiration(const engine_t *e) {
+    return e->ops->aspiration(e->impl);
+}
+
+void engine_set_lmr_moves(engine_t *e, int moves) {
+    e->ops->setLmrMoves(e->impl, moves);
+}
+
+int engine_lmr_moves(const engine_t *e) {
+    return e->ops->lmrMoves(e->impl);
+}
+
+void engine_set_weights(engine_t *e, const int weights[ENGINE_WEIGHT_COUNT]) {
+    e->ops->setWeights(e->impl, weights);
+}
+
+void engine_weights(const engine_t *e, int weights[ENGINE_WEIGHT_COUNT]) {
+    e->ops->weights(e->impl, weights);
+}
+
+void engine_set_book(engine_t *e, const Book *book) {
+    e->ops->setBook(e->impl, book);
+}
+
+const Book *engine_book(const engine_t *e) {
+    return e->ops->book(e->impl);
+}
+
+void engine_book_entry(const engine_t *e, int row, int col, BookEntry *entry) {
+    e->ops->bookEntry(e->impl, row, col, entry);
+}
+
+int engine_set_hash_size(engine_t *e, size_t megabytes) {
+    return e->ops->setHashSize(e->impl, megabytes);
+}
+
+size_t engine_hash_size(const engine_t *e) {
+    return e->ops->hashSize(e->impl);
+}
+
+void engine_clear_hash(engine_t *e) {
+    e->ops->clearHash(e->impl);
+}
+
+void engine_memory(const engine_t *e, engine_memory_t *memory) {
+    e->ops->memory(e->impl, memory);
+    if (e->bytes > 0) {
+        memory->limit = memory->total = e->bytes;
+    } else {
+        memory->total += sizeof(engine_t);
+    }
+}
@@ -0,0 +1,77 @@
+/*
+ * 五子棋引擎库 libgobang - 各棋盘尺寸的引擎实例
+ * 版权所有 (C) 2024 [大龙软件 bigdragonsoft.com]
+ *
+ * engine.c 按 ENGINE_SIZES 中的每个尺寸各编译一次（-DBOARD_SIZE=N），
+ * 棋盘边长在每个实例中都是编译期常量。每个实例导出一张函数表，
+ * engineops.c 中的公开接口按引擎的尺寸转发到对应的函数表。
+ * 只在库内部使用。
+ */
+
+#ifndef GOBANG_ENGINEOPS_H
+#define GOBANG_ENGINEOPS_H
+
+#include "engine.h"
+
+// 编译进库的棋盘尺寸，须与 Makefile 中的 sizes 一致
+#define ENGINE_SIZES(X) X(15) X(19) X(20)
+
+// 某一尺寸的引擎实例，在该尺寸的 engine.c 中定义
+typedef struct Engine Engine;
+
+/**
+ * 一个尺寸的引擎实例的函数表，各函数的含义同 engine.h 中对应的公开接口
+ */
+typedef struct {
+    int size;  // 棋盘边长
+
+    Engine *(*create)(void);
+    Engine *(*createLimited)(void *block, size_t bytes);  // 在调用方的 bytes 字节内存块中创建，destroy 不释放该块
+    void (*destroy)(Engine *e);
+    void (*init)(Engine *e);
+    int (*makeMove)(Engine *e, int row, int col);
+    int (*undo)(Engine *e);
+    int (*search)(Engine *e, engine_result_t *result);
+    int (*ponder)(Engine *e);
+    int (*stopPonder)(Engine *e);
+    int (*stats)(const Engine *e, engine_stats_t *stats);
+    int (*solve)(Engine *e, int mode, engine_line_t *line);
+    uint64_t (*canonicalKey)(const Engine *e, int *transform);
+    void (*transformMove)(int transform, int row, int col, int *r, int *c);
+    void (*inverseMove)(int transform, int row, int col, int *r, int *c);
+    int (*evaluate)(const Engine *e);
+    int (*checkWin)(const Engine *e, int row, int col);
+    int (*stone)(const Engine *e, int row, int col);
+    int (*toMove)(const Engine *e);
+    int (*moveCount)(const Engine *e);
+    int (*lastMove)(const Engine *e, int *row, int *col);
+    void (*setDepth)(Engine *e, int depth);
+    int (*depth)(const Engine *e);
+    int (*maxDepth)(void);
+    void (*setTimeLimit)(Engine *e, int ms);
+    int (*timeLimit)(const Engine *e);
+    int (*setThreads)(Engine *e, int threads);
+    int (*threads)(const Engine *e);
+    void (*setThreatNodes)(Engine *e, unsigned long nodes);
+    unsigned long (*threatNodes)(const Engine *e);
+    void (*setAspiration)(Engine *e, int window);
+    int (*aspiration)(const Engine *e);
+    void (*setLmrMoves)(Engine *e, int moves);
+    int (*lmrMoves)(const Engine *e);
+    void (*setWeights)(Engine *e, const int weights[ENGINE_WEIGHT_COUNT]);
+    void (*weights)(const Engine *e, int weights[ENGINE_WEIGHT_COUNT]);
+    void (*setBook)(Engine *e, const Book *book);
+    const Book *(*book)(const Engine *e);
+    void (*bookEntry)(const Engine *e, int row, int col, BookEntry *entry);
+    int (*setHashSize)(Engine *e, size_t megabytes);
+    size_t (*hashSize)(const Engine *e);
+    void (*clearHash)(Engine *e);
+    void (*memory)(const Engine *e, engine_memory_t *memory);
+} EngineOps;
+
+// 各尺寸的函数表：engineOps15、engineOps19 ……
+#define ENGINE_DECLARE_OPS(n) extern const EngineOps engineOps##n;
+ENGINE_SIZES(ENGINE_DECLARE_OPS)
+#undef ENGINE_DECLARE_OPS
+
+#endif
@@ -23,344 +23,219 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
-#include <limits.h>
-#include <unistd.h>
 #include <string.h>
 #include <ctype.h>
 
-#define BOARD_SIZE 15
-#define EMPTY 0
-#define BLACK 1
-#define WHITE 2
-
-#define MAX_DEPTH 5
-#define SEARCH_RANGE 2
-
-// 使用 INT_MAX 和 INT_MIN 替代 INF
-#define INF INT_MAX
-#define NEG_INF INT_MIN
-
-#define EASY_DEPTH 2
-#define MEDIUM_DEPTH 3
-#define HARD_DEPTH 4
+#include "engine.h"
+#include "protocol.h"
+#include "server.h"
+#include "selfplay.h"
+#include "analyze.h"
+#include "record.h"
+#include "render.h"
 
 #define VERSION "0.1.2"
 #define AUTHOR "Qiang Guo"
 #define EMAIL "bigdragonsoft@gmail.com"
 #define WEBSITE "https://github.com/bigdragonsoft/gobang"
 
-int board[BOARD_SIZE][BOARD_SIZE] = {0};
-
-int AI_DEPTH = MEDIUM_DEPTH;  // 默认中等难度
+#define DEFAULT_HASH_MB 16  // 置换表默认大小（MB）
+#define BOOK_RECORD_PLIES 12  // 由棋谱生成开局库时每局取的步数
 
 int gameMode = 0;  // 0: 未设置, 1: 双人模式, 2: 人机模式
 
-/**
- * @brief 初始化棋盘
- * 
- * 将棋盘上所有位置初始化为空（'.'）
- */
-void initBoard() {
-    for (int i = 0; i < BOARD_SIZE; i++) {
-        for (int j = 0; j < BOARD_SIZE; j++) {
-            board[i][j] = EMPTY;
-        }
-    }
-}
+engine_t *aiEngine = NULL;  // 对局状态和电脑的搜索设置
+
+engine_result_t lastSearch;  // 电脑最近一步的搜索结果，重画棋盘后显示
+
+int ponder = 0;           // 为1时电脑在玩家思考期间后台思考
+int lastPonderDepth = 0;  // 玩家上一步期间后台思考完成的深度
+
+Screen *screen = NULL;  // 控制台画面，printBoard() 一次输出一帧
+int diffScreen = 0;     // 为1时只重画与上一帧不同的行
+
+RecordWriter *gameRecord = NULL;  // 不为 NULL 时每局结束后追加到该棋谱文件
+GameRecord history;               // 当前一局的着法
 
 /**
  * @brief 打印棋盘
  * 
- * 在控制台上显示居中的游戏标题和当前棋盘状态
+ * 在控制台上显示居中的游戏标题和当前棋盘状态。整个画面写成一帧后一次输出，
+ * 光标停在画面下一行的行首
+ * 
+ * @param e 引擎
  */
-void printBoard() {
-    int boardWidth = BOARD_SIZE * 2 + 2;  // 棋盘的宽度（每个格子占2个字符，加上行号）
+void printBoard(const engine_t *e) {
+    int size = engine_size(e);
+    int boardWidth = size * 2 + 2;  // 棋盘的宽度（每个格子占2个字符，加上行号）
     const char *titleText = "Gobang Game";
     int titleWidth = strlen(titleText);
     int versionWidth = strlen(VERSION);
     int totalWidth = titleWidth > boardWidth ? titleWidth : boardWidth;
 
+    screenBegin(screen);
+
     // 打印标题
-    printf("\n");
+    screenPrintf(screen, "\n");
     
     // 上边框
-    printf("%*s", (totalWidth - titleWidth) / 2, "");
-    for (int i = 0; i < titleWidth; i++) printf("-");
-    printf("\n");
+    screenPrintf(screen, "%*s", (totalWidth - titleWidth) / 2, "");
+    for (int i = 0; i < titleWidth; i++) screenPrintf(screen, "-");
+    screenPrintf(screen, "\n");
     
     // 标题文字
-    printf("%*s%s\n", (totalWidth - titleWidth) / 2, "", titleText);
+    screenPrintf(screen, "%*s%s\n", (totalWidth - titleWidth) / 2, "", titleText);
     
     // 下边框
-    printf("%*s", (totalWidth - titleWidth) / 2, "");
-    for (int i = 0; i < titleWidth; i++) printf("-");
-    printf("\n");
+    screenPrintf(screen, "%*s", (totalWidth - titleWidth) / 2, "");
+    for (int i = 0; i < titleWidth; i++) screenPrintf(screen, "-");
+    screenPrintf(screen, "\n");
 
     // 版本号
-    printf("%*sv%s\n\n", (totalWidth - versionWidth) / 2, "", VERSION);
+    screenPrintf(screen, "%*sv%s\n\n", (totalWidth - versionWidth) / 2, "", VERSION);
 
     // 打印列号
-    printf("  ");
-    for (int i = 0; i < BOARD_SIZE; i++) {
-        if (i < 10) {
-            printf("%2d", i);
-        } else {
-            printf("%2c", 'A' + (i - 10));
-        }
+    screenPrintf(screen, "  ");
+    for (int i = 0; i < size; i++) {
+        screenPrintf(screen, "%2c", bookCoordChar(i));
     }
-    printf("\n");
+    screenPrintf(screen, "\n");
 
     // 打印棋盘
-    for (int i = 0; i < BOARD_SIZE; i++) {
-        if (i < 10) {
-            printf("%2d", i);
-        } else {
-            printf("%2c", 'A' + (i - 10));
-        }
-        for (int j = 0; j < BOARD_SIZE; j++) {
-            switch(board[i][j]) {
-                case EMPTY: printf(" ·"); break;
-                case BLACK: printf(" ●"); break;  // 黑子用实心圆
-                case WHITE: printf(" ○"); break;  // 白子用空心圆
+    for (int i = 0; i < size; i++) {
+        screenPrintf(screen, "%2c", bookCoordChar(i));
+        for (int j = 0; j < size; j++) {
+            switch(engine_stone(e, i, j)) {
+                case EMPTY: screenPrintf(screen, " ·"); break;
+                case BLACK: screenPrintf(screen, " ●"); break;  // 黑子用实心圆
+                case WHITE: screenPrintf(screen, " ○"); break;  // 白子用空心圆
             }
         }
-        printf("\n");
+        screenPrintf(screen, "\n");
     }
 
     // 在棋盘下方显示AI难度
-    if (gameMode == 2) {
-        switch (AI_DEPTH) {
+    if (gameMode == 2 && engine_time_limit(e) > 0) {
+        screenPrintf(screen, "\nAI Time Limit %d ms\n", engine_time_limit(e));
+    } else if (gameMode == 2) {
+        switch (engine_depth(e)) {
             case EASY_DEPTH:
-                printf("\nAI Difficulty Easy\n");
+                screenPrintf(screen, "\nAI Difficulty Easy\n");
                 break;
             case MEDIUM_DEPTH:
-                printf("\nAI Difficulty Medium\n");
+                screenPrintf(screen, "\nAI Difficulty Medium\n");
                 break;
             case HARD_DEPTH:
-                printf("\nAI Difficulty Hard\n");
+                screenPrintf(screen, "\nAI Difficulty Hard\n");
+                break;
+            case EXPERT_DEPTH:
+                screenPrintf(screen, "\nAI Difficulty Expert\n");
                 break;
             default:
-                printf("\nAI Difficulty Unknown\n");
+                screenPrintf(screen, "\nAI Difficulty Unknown\n");
         }
     }
+    screenShow(screen);
 }
 
 /**
- * @brief 检查是否有五子连珠
+ * @brief 显示一次搜索的 info 行（格式类似 UCI 引擎）
  * 
- * @param row 最后一步棋的行号
- * @param col 最后一步棋的列号
- * @return int 如果有五子连珠返回1，否则返回0
- */
-int checkWin(int row, int col) {
-    int player = board[row][col];
-    int directions[4][2] = {{0,1}, {1,0}, {1,1}, {1,-1}};
-    
-    for (int d = 0; d < 4; d++) {
-        int count = 1;
-        // 向一个方向检查
-        for (int i = 1; i <= 4; i++) {
-            int newRow = row + directions[d][0] * i;
-            int newCol = col + directions[d][1] * i;
-            if (newRow < 0 || newRow >= BOARD_SIZE || newCol < 0 || newCol >= BOARD_SIZE || board[newRow][newCol] != player) {
-                break;
-            }
-            count++;
-        }
-        // 向相反方向检查
-        for (int i = 1; i <= 4; i++) {
-            int newRow = row - directions[d][0] * i;
-            int newCol = col - directions[d][1] * i;
-            if (newRow < 0 || newRow >= BOARD_SIZE || newCol < 0 || newCol >= BOARD_SIZE || board[newRow][newCol] != player) {
-                break;
-            }
-            count++;
-        }
-        if (count >= 5) return 1;
-    }
-    return 0;
-}
-
-/**
- * @brief 评估棋盘状态
+ * 库编译时收集了搜索统计的，再显示评估次数、置换表命中率、截断情况和每层用时。
  * 
- * @param row 最后一步棋的行号
- * @param col 最后一步棋的列号
- * @param player 当前玩家的棋符号
- * @return int 盘状态的评分
+ * @param e 引擎
+ * @param result 搜索结果
  */
-int evaluatePosition(int row, int col, int player) {
-    int score = 0;
-    int directions[4][2] = {{0,1}, {1,0}, {1,1}, {1,-1}};
-    
-    for (int d = 0; d < 4; d++) {
-        int count = 1;
-        int block = 0;
-        
-        // 向一个方向检查
-        for (int i = 1; i <= 4; i++) {
-            int newRow = row + directions[d][0] * i;
-            int newCol = col + directions[d][1] * i;
-            if (newRow < 0 || newRow >= BOARD_SIZE || newCol < 0 || newCol >= BOARD_SIZE) {
-                block++;
-                break;
-            }
-            if (board[newRow][newCol] == player) count++;
-            else if (board[newRow][newCol] != EMPTY) {
-                block++;
-                break;
-            }
-            else break;
-        }
-        
-        // 向相反方向检查
-        for (int i = 1; i <= 4; i++) {
-            int newRow = row - directions[d][0] * i;
-            int newCol = col - directions[d][1] * i;
-            if (newRow < 0 || newRow >= BOARD_SIZE || newCol < 0 || newCol >= BOARD_SIZE) {
-                block++;
-                break;
-            }
-            if (board[newRow][newCol] == player) count++;
-            else if (board[newRow][newCol] != EMPTY) {
-                block++;
-                break;
-            }
-            else break;
-        }
-        
-        // 评估
-        if (count >= 5) score += 100000;
-        else if (count == 4 && block == 0) score += 10000;
-        else if (count == 4 && block == 1) score += 1000;
-        else if (count == 3 && block == 0) score += 1000;
-        else if (count == 3 && block == 1) score += 100;
-        else if (count == 2 && block == 0) score += 100;
+void printSearchInfo(const engine_t *e, const engine_result_t *result) {
+    if (result->fromBook) {
+        printf("info book move (%d, %d)\n", result->row, result->col);
+        return;
     }
-    
-    return score;
-}
-
-/**
- * @brief 评估整个棋盘状态
- * 
- * @return int 棋盘状态的评分
- */
-int evaluateBoard() {
-    int score = 0;
-    for (int i = 0; i < BOARD_SIZE; i++) {
-        for (int j = 0; j < BOARD_SIZE; j++) {
-            if (board[i][j] == WHITE) {
-                score += evaluatePosition(i, j, WHITE);
-            } else if (board[i][j] == BLACK) {
-                score -= evaluatePosition(i, j, BLACK);
-            }
-        }
+    // 必胜必败分显示为成五前的步数，类似 UCI 的 score mate
+    printf("info depth %d score ", result->depth);
+    if (result->score >= ENGINE_WIN_BOUND) {
+        printf("win %d", ENGINE_WIN_SCORE - result->score);
+    } else if (result->score <= -ENGINE_WIN_BOUND) {
+        printf("loss %d", ENGINE_WIN_SCORE + result->score);
+    } else {
+        printf("%d", result->score);
+    }
+    printf(" nodes %llu time %lld nps %llu", result->nodes, result->timeMs,
+           result->nodes * 1000 / (result->timeMs > 0 ? result->timeMs : 1));
+    if (result->forced.length > 0) {
+        printf(" forced %d", result->forced.length);
+    }
+    if (lastPonderDepth > 0) {
+        printf(" ponder %d", lastPonderDepth);
     }
-    return score;
-}
 
-/**
- * @brief 检查是否在搜索围内
- * 
- * @param row 行号
- * @param col 列号
- * @return int 如果在搜索范围内返回1，否则返回0
- */
-int inSearchRange(int row, int col) {
-    for (int i = row - SEARCH_RANGE; i <= row + SEARCH_RANGE; i++) {
-        for (int j = col - SEARCH_RANGE; j <= col + SEARCH_RANGE; j++) {
-            if (i >= 0 && i < BOARD_SIZE && j >= 0 && j < BOARD_SIZE) {
-                if (board[i][j] != EMPTY) {
-                    return 1;
-                }
-            }
+    engine_stats_t stats;
+    if (engine_stats(e, &stats) != 0) {
+        printf("\n");
+        return;
+    }
+    printf(" evals %llu tthits %.1f%% cutoffs %llu",
+           stats.evaluations, stats.ttProbes ? 100.0 * stats.ttHits / stats.ttProbes : 0.0, stats.cutoffs);
+    if (stats.cutoffs > 0) {
+        // 截断中由第1、第2个着法引起的比例，反映着法排序的好坏
+        printf(" first %.1f%% second %.1f%%",
+               100.0 * stats.cutoffsAt[0] / stats.cutoffs, 100.0 * stats.cutoffsAt[1] / stats.cutoffs);
+    }
+    if (stats.researches > 0) {
+        printf(" researches %llu", stats.researches);
+    }
+    printf("\n");
+    if (stats.depths > 0) {
+        printf("info depthtime");
+        for (int d = 1; d <= stats.depths; d++) {
+            printf(" %d:%lldms/%llu", d, stats.depthMs[d], stats.depthNodes[d]);
         }
+        printf("\n");
     }
-    return 0;
 }
 
 /**
- * @brief 极小化极大算法的实现
+ * @brief 电脑下棋
+ * 
+ * 按引擎的搜索设置为轮到的一方选择最佳落子位置并落子，找到必胜时显示必胜序列。
+ * 搜索结果存入 lastSearch。
  * 
- * @param depth 当搜索深度
- * @param alpha Alpha值
- * @param beta Beta值
- * @param maximizingPlayer 是否为极大化玩家
- * @return int 最佳评分
+ * @param e 引擎
+ * @param row 输出：落子的行号
+ * @param col 输出：落子的列号
  */
-int minimax(int depth, int alpha, int beta, int maximizingPlayer) {
-    if (depth == 0 || depth >= MAX_DEPTH) {
-        return evaluateBoard();
-    }
-
-    if (maximizingPlayer) {
-        int maxEval = NEG_INF;
-        for (int i = 0; i < BOARD_SIZE; i++) {
-            for (int j = 0; j < BOARD_SIZE; j++) {
-                if (board[i][j] == EMPTY && inSearchRange(i, j)) {
-                    board[i][j] = WHITE;
-                    int eval = minimax(depth - 1, alpha, beta, 0);
-                    board[i][j] = EMPTY;
-                    maxEval = (eval > maxEval) ? eval : maxEval;
-                    alpha = (alpha > eval) ? alpha : eval;
-                    if (beta <= alpha) {
-                        return maxEval;
-                    }
-                }
-            }
+void makeAIMove(engine_t *e, int* row, int* col) {
+    engine_result_t result;
+    engine_search(e, &result);
+    lastSearch = result;
+    engine_make_move(e, result.row, result.col);
+    printf("AI placed a move at (%d, %d)%s\n", result.row, result.col, result.fromBook ? " from the opening book" : "");
+    if (result.forced.length > 0) {
+        printf("AI found a forced win:");
+        for (int k = 0; k < result.forced.length; k++) {
+            printf(" (%d, %d)", result.forced.row[k], result.forced.col[k]);
         }
-        return maxEval;
-    } else {
-        int minEval = INF;
-        for (int i = 0; i < BOARD_SIZE; i++) {
-            for (int j = 0; j < BOARD_SIZE; j++) {
-                if (board[i][j] == EMPTY && inSearchRange(i, j)) {
-                    board[i][j] = BLACK;
-                    int eval = minimax(depth - 1, alpha, beta, 1);
-                    board[i][j] = EMPTY;
-                    minEval = (eval < minEval) ? eval : minEval;
-                    beta = (beta < eval) ? beta : eval;
-                    if (beta <= alpha) {
-                        return minEval;
-                    }
-                }
-            }
-        }
-        return minEval;
+        printf("\n");
     }
+
+    *row = result.row;
+    *col = result.col;
 }
 
 /**
- * @brief 电脑下棋
+ * @brief 把当前一局追加到棋谱文件，没有指定棋谱文件或一步未走时什么也不做
  * 
- * 使用极小化极大算法选择最佳落子位置
+ * @param moveCount 已走的步数
+ * @param winner 胜方，和棋或未下完为 EMPTY
  */
-void makeAIMove(int* row, int* col) {
-    int bestScore = NEG_INF;
-    int bestRow = -1, bestCol = -1;
-    
-    for (int i = 0; i < BOARD_SIZE; i++) {
-        for (int j = 0; j < BOARD_SIZE; j++) {
-            if (board[i][j] == EMPTY && inSearchRange(i, j)) {
-                board[i][j] = WHITE;
-                int score = minimax(AI_DEPTH - 1, NEG_INF, INF, 0);  // 使用 AI_DEPTH
-                board[i][j] = EMPTY;
-                
-                if (score > bestScore) {
-                    bestScore = score;
-                    bestRow = i;
-                    bestCol = j;
-                }
-            }
-        }
+static void saveGame(int moveCount, int winner) {
+    if (gameRecord == NULL || moveCount == 0) return;
+    history.size = engine_size(aiEngine);
+    history.moveCount = moveCount;
+    history.winner = winner;
+    if (recordWrite(gameRecord, &history) != 0) {
+        printf("Cannot save the game record.\n");
     }
-    
-    board[bestRow][bestCol] = WHITE;
-    printf("AI placed a move at (%d, %d)\n", bestRow, bestCol);
-    
-    *row = bestRow;
-    *col = bestCol;
 }
 
 /**
@@ -388,11 +263,12 @@ void playGame() {
         } while (gameMode == 0);
     }
 
-    if (gameMode == 2) {
+    // 限时模式按时间控制搜索深度，不再选择难度
+    if (gameMode == 2 && engine_time_limit(aiEngine) == 0) {
         int difficulty = 0;
         do {
-            printf("Select AI difficulty:\n1. Easy\n2. Medium\n3. Hard\n");
-            if (scanf("%d", &difficulty) != 1 || difficulty < 1 || difficulty > 3) {
+            printf("Select AI difficulty:\n1. Easy\n2. Medium\n3. Hard\n4. Expert\n");
+            if (scanf("%d", &difficulty) != 1 || difficulty < 1 || difficulty > 4) {
                 printf("Invalid choice, please try again.\n");
                 while (getchar() != '\n');  // 清除输入缓冲区
                 difficulty = 0;  // 重置difficulty
@@ -403,32 +279,44 @@ void playGame() {
 
         switch (difficulty) {
             case 1:
-                AI_DEPTH = EASY_DEPTH;
+                engine_set_depth(aiEngine, EASY_DEPTH);
                 break;
             case 2:
-                AI_DEPTH = MEDIUM_DEPTH;
+                engine_set_depth(aiEngine, MEDIUM_DEPTH);
                 break;
             case 3:
-                AI_DEPTH = HARD_DEPTH;
+                engine_set_depth(aiEngine, HARD_DEPTH);
+                break;
+            case 4:
+                engine_set_depth(aiEngine, EXPERT_DEPTH);
                 break;
         }
     }
 
     do {
         srand(time(NULL));  // 初始化随机数生成器
-        initBoard();
+        engine_init(aiEngine);
         moves = 0;
         currentPlayer = BLACK;
 
         while (1) {
-            system("clear");
-            printBoard();
+            printBoard(aiEngine);
             
             if (currentPlayer == BLACK || gameMode == 1) {
                 int validMove = 0;
-                while (!validMove) {
+                int undone = 0;
+                int prompts = 0;
+                // 人机模式下等玩家落子的同时让电脑在后台思考
+                if (ponder && gameMode == 2 && moves > 0) {
+                    engine_ponder(aiEngine);
+                }
+                while (!validMove && !undone) {
+                    // 重复提示会让屏幕滚动，下一帧不能再按行号差量重画
+                    if (++prompts > 1) {
+                        screenInvalidate(screen);
+                    }
                     printf("Player %s\n", currentPlayer == BLACK ? "Black" : "White");
-                    printf("Enter move position, or 'q' to quit: ");
+                    printf("Enter move position, 'u' to undo, or 'q' to quit: ");
                     char input[10];
                     if (fgets(input, sizeof(input), stdin) == NULL) {
                         printf("Input error, please try again.\n");
@@ -438,68 +326,86 @@ void playGame() {
                     // 检查是否输入了 'q'
                     if (input[0] == 'q' || input[0] == 'Q') {
                         printf("Game over.\n");
+                        saveGame(moves, EMPTY);
                         return;  // 退出游戏
                     }
 
+                    // 悔棋：人机模式撤销电脑和自己各一步，双人模式撤销一步
+                    if (input[0] == 'u' || input[0] == 'U') {
+                        int plies = gameMode == 2 ? 2 : 1;
+                        if (moves < plies) {
+                            printf("Nothing to undo.\n");
+                            continue;
+                        }
+                        for (int k = 0; k < plies; k++) {
+                            engine_undo(aiEngine);
+                        }
+                        moves -= plies;
+                        if (plies == 1) {
+                            currentPlayer = (currentPlayer == BLACK) ? WHITE : BLACK;
+                        }
+                        undone = 1;
+                        continue;
+                    }
+
                     char rowInput, colInput;
                     if (sscanf(input, "%c %c", &rowInput, &colInput) != 2) {
                         printf("Invalid input, please enter two characters.\n");
                         continue;
                     }
 
-                    // 将输入转换为大写
-                    rowInput = toupper(rowInput);
-                    colInput = toupper(colInput);
-
-                    // 处理行输入
-                    if (rowInput >= '0' && rowInput <= '9') {
-                        row = rowInput - '0';
-                    } else if (rowInput >= 'A' && rowInput <= 'E') {
-                        row = 10 + (rowInput - 'A');
-                    } else {
+                    // 处理行、列输入
+                    int size = engine_size(aiEngine);
+                    row = bookCoordValue(rowInput, size);
+                    col = bookCoordValue(colInput, size);
+                    if (row < 0) {
                         printf("Invalid row coordinate, please try again.\n");
                         continue;
                     }
-
-                    // 处理列输入
-                    if (colInput >= '0' && colInput <= '9') {
-                        col = colInput - '0';
-                    } else if (colInput >= 'A' && colInput <= 'E') {
-                        col = 10 + (colInput - 'A');
-                    } else {
+                    if (col < 0) {
                         printf("Invalid column coordinate, please try again.\n");
                         continue;
                     }
 
-                    if (row < 0 || row >= BOARD_SIZE || col < 0 || col >= BOARD_SIZE || board[row][col] != EMPTY) {
+                    if (engine_stone(aiEngine, row, col) != EMPTY) {
                         printf("Invalid move position, please try again.\n");
                         continue;
                     }
 
                     validMove = 1;
                 }
+                lastPonderDepth = engine_stop_ponder(aiEngine);
+                if (undone) {
+                    continue;  // 重画棋盘，仍由悔棋后轮到的一方走
+                }
 
-                board[row][col] = currentPlayer;
+                engine_make_move(aiEngine, row, col);
             } else {
-                makeAIMove(&row, &col);
+                makeAIMove(aiEngine, &row, &col);
             }
 
+            history.rows[moves] = (uint8_t)row;
+            history.cols[moves] = (uint8_t)col;
             moves++;
 
-            system("clear");
-            printBoard();
+            printBoard(aiEngine);
+            if (gameMode == 2 && currentPlayer == WHITE) {
+                printSearchInfo(aiEngine, &lastSearch);
+            }
 
-            if (checkWin(row, col)) {
+            if (engine_check_win(aiEngine, row, col)) {
                 if (gameMode == 2 && currentPlayer == WHITE) {
                     printf("AI wins!\n");
                 } else {
                     printf("Player %s wins!\n", currentPlayer == BLACK ? "Black" : "White");
                 }
+                saveGame(moves, currentPlayer);
                 break;
             }
 
-            if (moves == BOARD_SIZE * BOARD_SIZE) {
+            if (moves == engine_size(aiEngine) * engine_size(aiEngine)) {
                 printf("It's a draw!\n");
+                saveGame(moves, EMPTY);
                 break;
             }
 
@@ -516,27 +422,254 @@ void playGame() {
     printf("Thanks for playing, goodbye!\n");
 }
 
+// 基准测试局面：着法按落子顺序排列，每步为行号、列号两个字符（0-9、A-E）
+static const struct {
+    const char *name;
+    const char *moves;
+} benchPositions[] = {
+    { "opening",  "7766" },
+    { "opening",  "77686655" },
+    { "opening",  "778688667675" },
+    { "middle",   "77666886597656655796A658" },
+    { "middle",   "777869586867594A493986956A89569A" },
+    { "middle",   "7788685967878695574766697696465624356465" },
+    { "endgame",  "7766574746686758879778697A36257989566B98888A86855C4D" },
+    { "endgame",  "776857474866675687977665743829758558639686848889524194A3" },
+    { "endgame",  "7786757484667665787967564783925758853669684888982514493A8963" },
+};
+
+#define BENCH_POSITIONS ((int)(sizeof(benchPositions) / sizeof(benchPositions[0])))
+
+/**
+ * @brief 基准测试
+ * 
+ * 对内置的开局、中局、残局局面逐个搜索，每个局面之前清空置换表，
+ * 输出每个局面和总计的节点数、用时、每秒节点数和选中的着法。
+ * 总节点数作为基准签名，单线程时对同一版本的程序总是相同。
+ * 
+ * 局面按 15 路棋盘给出，在更大的棋盘上同样可用，签名随棋盘尺寸而不同。
+ * 
+ * @param e 引擎，使用其棋盘尺寸、线程数和置换表设置
+ * @param depth 搜索深度
+ * @return int 成功返回0，内置局面有误返回1
+ */
+int runBench(engine_t *e, int depth) {
+    unsigned long long totalNodes = 0;
+    long long totalMs = 0;
+
+    engine_set_depth(e, depth);
+    engine_set_time_limit(e, 0);
+    printf("Bench size %d depth %d\n\n", engine_size(e), depth);
+
+    for (int n = 0; n < BENCH_POSITIONS; n++) {
+        const char *moves = benchPositions[n].moves;
+        engine_init(e);
+        engine_clear_hash(e);
+        for (int k = 0; moves[k] != '\0'; k += 2) {
+            if (engine_make_move(e, bookCoordValue(moves[k], engine_size(e)), bookCoordValue(moves[k + 1], engine_size(e))) != 0) {
+                printf("Bad move at offset %d in bench position %d.\n", k, n + 1);
+                return 1;
+            }
+        }
+
+        engine_result_t result;
+        engine_search(e, &result);
+        totalNodes += result.nodes;
+        totalMs += result.timeMs;
+        printf("Position %2d %-8s stones %3d  move (%2d, %2d)  nodes %10llu  time %6lld ms  nps %10llu\n",
+               n + 1, benchPositions[n].name, engine_move_count(e), result.row, result.col,
+               result.nodes, result.timeMs, result.nodes * 1000 / (result.timeMs > 0 ? result.timeMs : 1));
+    }
+
+    printf("\nTotal nodes %llu  time %lld ms  nps %llu\n",
+           totalNodes, totalMs, totalNodes * 1000 / (totalMs > 0 ? totalMs : 1));
+    printf("Bench signature: %llu\n", totalNodes);
+    return 0;
+}
+
+/**
+ * @brief 为当前局面下的一步棋增加一条开局库记录，再走这步棋
+ * 
+ * @param e 引擎
+ * @param row 行号
+ * @param col 列号
+ * @param entries 输入输出：记录数组，按需扩大
+ * @param count 输入输出：记录数
+ * @param capacity 输入输出：数组容量
+ * @return int 成功返回0，内存不足返回-1
+ */
+static int addBookMove(engine_t *e, int row, int col, BookEntry **entries, size_t *count, size_t *capacity) {
+    if (*count == *capacity) {
+        size_t grown = *capacity ? *capacity * 2 : 1024;
+        BookEntry *larger = realloc(*entries, grown * sizeof(BookEntry));
+        if (larger == NULL) {
+            return -1;
+        }
+        *entries = larger;
+        *capacity = grown;
+    }
+    engine_book_entry(e, row, col, &(*entries)[(*count)++]);
+    engine_make_move(e, row, col);
+    return 0;
+}
+
+/**
+ * @brief 读入文本开局的所有记录
+ * 
+ * 文本每行是一局的前若干步，写法与基准测试局面相同，空白忽略，
+ * 空行和以 '#' 开头的行跳过。
+ * 
+ * @return int 成功返回0，失败返回1
+ */
+static int readBookText(engine_t *e, const char *textPath, BookEntry **entries, size_t *count, size_t *capacity) {
+    FILE *fp = fopen(textPath, "r");
+    if (fp == NULL) {
+        printf("Cannot open %s\n", textPath);
+        return 1;
+    }
+
+    char line[1024];
+    int lineNumber = 0;
+    int status = 0;
+    while (status == 0 && fgets(line, sizeof(line), fp) != NULL) {
+        lineNumber++;
+        if (line[0] == '#') continue;
+
+        engine_init(e);
+        int coords[2], n = 0;
+        for (const char *p = line; *p != '\0' && status == 0; p++) {
+            if (isspace((unsigned char)*p)) continue;
+            coords[n++] = bookCoordValue(*p, engine_size(e));
+            if (n < 2) continue;
+            n = 0;
+
+            if (coords[0] < 0 || coords[1] < 0 || engine_stone(e, coords[0], coords[1]) != EMPTY) {
+                printf("Bad move on line %d of %s\n", lineNumber, textPath);
+                status = 1;
+            } else if (addBookMove(e, coords[0], coords[1], entries, count, capacity) != 0) {
+                printf("Out of memory.\n");
+                status = 1;
+            }
+        }
+        if (status == 0 && n != 0) {
+            printf("Incomplete move on line %d of %s\n", lineNumber, textPath);
+            status = 1;
+        }
+    }
+    fclose(fp);
+    return status;
+}
+
+/**
+ * @brief 读入棋谱文件中每局前 BOOK_RECORD_PLIES 步的记录，棋盘尺寸不同的对局跳过
+ * 
+ * @return int 成功返回0，失败返回1
+ */
+static int readBookRecords(engine_t *e, const char *recordPath, BookEntry **entries, size_t *count, size_t *capacity) {
+    RecordReader *reader = recordOpenReader(recordPath);
+    if (reader == NULL) {
+        printf("Cannot open %s\n", recordPath);
+        return 1;
+    }
+
+    GameRecord game;
+    int games = 0;
+    int status = 0, got;
+    while (status == 0 && (got = recordRead(reader, &game)) == 1) {
+        games++;
+        if (game.size != engine_size(e)) continue;
+
+        engine_init(e);
+        for (int k = 0; k < game.moveCount && k < BOOK_RECORD_PLIES && status == 0; k++) {
+            if (engine_stone(e, game.rows[k], game.cols[k]) != EMPTY) {
+                printf("Bad move in game %d of %s\n", games, recordPath);
+                status = 1;
+            } else if (addBookMove(e, game.rows[k], game.cols[k], entries, count, capacity) != 0) {
+                printf("Out of memory.\n");
+                status = 1;
+            }
+        }
+    }
+    if (status == 0 && got < 0) {
+        printf("Damaged record after game %d of %s\n", games, recordPath);
+        status = 1;
+    }
+    recordCloseReader(reader);
+    return status;
+}
+
+/**
+ * @brief 由文本开局或棋谱文件生成开局库文件
+ * 
+ * 源文件以 RECORD_MAGIC 开头的按棋谱文件读，否则按文本开局读。
+ * 每一步都为它之前的局面生成一条记录。
+ * 
+ * @param e 引擎，用于计算规范化的局面哈希
+ * @param textPath 文本开局文件或棋谱文件
+ * @param bookPath 输出的开局库文件
+ * @return int 成功返回0，失败返回1
+ */
+int buildBook(engine_t *e, const char *textPath, const char *bookPath) {
+    BookEntry *entries = NULL;
+    size_t count = 0, capacity = 0;
+    int status = recordIsFile(textPath) ? readBookRecords(e, textPath, &entries, &count, &capacity)
+                                        : readBookText(e, textPath, &entries, &count, &capacity);
+
+    if (status == 0) {
+        long written = bookWrite(bookPath, entries, count);
+        if (written < 0) {
+            printf("Cannot write %s\n", bookPath);
+            status = 1;
+        } else {
+            printf("Wrote %ld book entries to %s\n", written, bookPath);
+        }
+    }
+    free(entries);
+    return status;
+}
+
 /**
  * @brief 主函数
  * 
  * @return int 程序退出状态
  */
 int main(int argc, char *argv[]) {
+    int size = ENGINE_DEFAULT_SIZE;
+    int depth = MEDIUM_DEPTH;
+    int timeLimitMs = 0;
+    int threads = 1;
+    size_t hashMegabytes = DEFAULT_HASH_MB;
+    int hashGiven = 0;  // 是否用 -m 指定了置换表大小
+    int benchDepth = 0;  // 大于0时运行基准测试
+    const char *bookPath = NULL;
+    const char *bookSource = NULL;  // 不为 NULL 时由该文本文件生成开局库
+    int protocol = 0;               // 为1时以 Piskvork 协议运行
+    SelfplayConfig selfplay;        // games 大于0时运行自对弈
+    memset(&selfplay, 0, sizeof(selfplay));
+    selfplay.jobs = 1;
+    defaultEngineSpec(&selfplay.engines[0]);
+    defaultEngineSpec(&selfplay.engines[1]);
+    const char *analyzePath = NULL;  // 不为 NULL 时分析该文件中的局面
+    int analyzeDepth = 0;            // 分析时的搜索深度，0 表示只做静态评估
+    const char *recordPath = NULL;   // 不为 NULL 时对局追加到该棋谱文件
+    int servePort = 0;               // 大于0时在该端口运行对局服务器
+    int serveClients = SERVER_DEFAULT_CLIENTS;
+
     // 检查命令行参数
-    if (argc > 1) {
-        if (strcmp(argv[1], "-v") == 0) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-v") == 0) {
             printf("Gobang Game Version %s\n", VERSION);
             printf("Author: %s\n", AUTHOR);
             printf("Email: %s\n", EMAIL);
             printf("Website: %s\n", WEBSITE);
             printf("Copyright (C) 2024 BigDragonSoft.com\n");
             return 0;
-        } else if (strcmp(argv[1], "-h") == 0) {
+        } else if (strcmp(argv[i], "-h") == 0) {
             printf("Gobang Game\n\n");
             printf("This is a console-based Five in a Row game. Main features include:\n");
-            printf("1. 15x15 game board\n");
+            printf("1. 15x15, 19x19 or 20x20 game board\n");
             printf("2. Support for player vs player or player vs AI\n");
-            printf("3. Three difficulty levels for AI\n");
+            printf("3. Four difficulty levels for AI\n");
             printf("4. AI decision-making using minimax algorithm\n");
             printf("5. User-friendly command-line interface\n\n");
             printf("Usage:\n");
@@ -545,25 +678,247 @@ int main(int argc, char *argv[]) {
             printf("  ./gobang -h      Display this help information\n");
             printf("  ./gobang -2      Start the game in player vs player mode\n");
             printf("  ./gobang -1      Start the game in player vs AI mode\n");
+            printf("  ./gobang -t MS   Start player vs AI mode with MS milliseconds per AI move\n");
+            printf("  ./gobang -m MB   Set the AI hash table size in megabytes (default %d)\n", DEFAULT_HASH_MB);
+            printf("  ./gobang --size N  Play on an NxN board: 15 (default), 19 or 20\n");
+            printf("  ./gobang --threads N  Use N threads for the AI search (default 1)\n");
+            printf("  ./gobang --ponder  Let the AI think on your time while you choose your move\n");
+            printf("  ./gobang --diff    Redraw only the lines of the screen that changed after each move\n");
+            printf("  ./gobang --bench [DEPTH]  Search the built-in bench positions (default depth %d)\n", HARD_DEPTH);
+            printf("  ./gobang --book FILE  Play opening moves from the book FILE\n");
+            printf("  ./gobang --build-book TEXT FILE  Build the book FILE from the opening lines in TEXT or a game record\n");
+            printf("  ./gobang --protocol  Run headless, speaking the Piskvork/Gomocup protocol on stdin/stdout\n");
+            printf("  ./gobang --selfplay N [--jobs J]  Play N AI vs AI games, J at a time, and report W/L/D and Elo\n");
+            printf("  ./gobang --engine-a SPEC / --engine-b SPEC  Self-play engine settings, e.g. depth=4,time=500,\n");
+            printf("           threats=20000,aspiration=800,lmr=4,weights=100/100/1000/1000/10000/100000\n");
+            printf("  ./gobang --record FILE  Append every finished game, including self-play games, to the game record FILE\n");
+            printf("  ./gobang --analyze FILE [--depth N] [--jobs J]  Evaluate each position in FILE, searching to depth N\n");
+            printf("           (default 0: evaluation only) on J threads, and print one JSON line per position\n");
+            printf("  ./gobang --serve PORT [--clients N] [--jobs J] [-t MS]  Host PvP and PvAI games over TCP for up to N\n");
+            printf("           clients (default %d), with J AI threads and at most MS milliseconds per AI move (default %d)\n",
+                   SERVER_DEFAULT_CLIENTS, SERVER_DEFAULT_MOVE_MS);
             printf("\nFor more information, please use 'man gobang' to view the game manual page\n");
             return 0;
-        } else if (strcmp(argv[1], "-2") == 0) {
+        } else if (strcmp(argv[i], "-2") == 0) {
             // 直接进入双人模式
             gameMode = 1;
-            playGame();
-            return 0;
-        } else if (strcmp(argv[1], "-1") == 0) {
+        } else if (strcmp(argv[i], "-1") == 0) {
             // 直接进入人机对战模式
             gameMode = 2;
-            AI_DEPTH = MEDIUM_DEPTH;  // 默认使用中等难度
-            playGame();
-            return 0;
+            depth = MEDIUM_DEPTH;  // 默认使用中等难度
+        } else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+            // 置换表内存预算
+            int megabytes = atoi(argv[++i]);
+            if (megabytes <= 0) {
+                printf("Invalid hash table size: %s\n", argv[i]);
+                return 1;
+            }
+            hashMegabytes = megabytes;
+            hashGiven = 1;
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            // 限时人机对战：每步思考时间（毫秒）
+            timeLimitMs = atoi(argv[++i]);
+            if (timeLimitMs <= 0) {
+                printf("Invalid time limit: %s\n", argv[i]);
+                return 1;
+            }
+            gameMode = 2;
+        } else if (strcmp(argv[i], "--ponder") == 0) {
+            // 玩家思考期间电脑后台思考
+            ponder = 1;
+        } else if (strcmp(argv[i], "--diff") == 0) {
+            // 每步只重画变化的行
+            diffScreen = 1;
+        } else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            // 棋盘尺寸
+            size = atoi(argv[++i]);
+            if (!engine_size_supported(size)) {
+                printf("Unsupported board size: %s\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            // 电脑思考时使用的线程数
+            threads = atoi(argv[++i]);
+            if (threads <= 0) {
+                printf("Invalid thread count: %s\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--bench") == 0) {
+            // 基准测试，可选指定搜索深度
+            benchDepth = HARD_DEPTH;
+            if (i + 1 < argc && isdigit((unsigned char)argv[i + 1][0])) {
+                benchDepth = atoi(argv[++i]);
+                if (benchDepth < 1 || benchDepth > engine_max_depth()) {
+                    printf("Invalid bench depth: %s\n", argv[i]);
+                    return 1;
+                }
+            }
+        } else if (strcmp(argv[i], "--protocol") == 0) {
+            // 无界面模式，由对局管理程序驱动
+            protocol = 1;
+        } else if (strcmp(argv[i], "--book") == 0 && i + 1 < argc) {
+            // 开局库文件
+            bookPath = argv[++i];
+        } else if (strcmp(argv[i], "--build-book") == 0 && i + 2 < argc) {
+            // 由文本开局生成开局库
+            bookSource = argv[++i];
+            bookPath = argv[++i];
+        } else if (strcmp(argv[i], "--selfplay") == 0 && i + 1 < argc) {
+            // 电脑对电脑批量对局
+            selfplay.games = atoi(argv[++i]);
+            if (selfplay.games <= 0) {
+                printf("Invalid number of games: %s\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) {
+            // 同时进行的自对弈局数
+            selfplay.jobs = atoi(argv[++i]);
+            if (selfplay.jobs <= 0) {
+                printf("Invalid job count: %s\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--serve") == 0 && i + 1 < argc) {
+            // 网络对局服务器的端口
+            servePort = atoi(argv[++i]);
+            if (servePort <= 0 || servePort > 65535) {
+                printf("Invalid port: %s\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--clients") == 0 && i + 1 < argc) {
+            // 网络对局服务器的最大连接数
+            serveClients = atoi(argv[++i]);
+            if (serveClients <= 0 || serveClients > SERVER_MAX_CLIENTS) {
+                printf("Invalid client count: %s\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--analyze") == 0 && i + 1 < argc) {
+            // 批量分析局面文件
+            analyzePath = argv[++i];
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            // 保存对局的棋谱文件
+            recordPath = argv[++i];
+        } else if (strcmp(argv[i], "--depth") == 0 && i + 1 < argc) {
+            // 分析局面的搜索深度
+            analyzeDepth = atoi(argv[++i]);
+            if (analyzeDepth < 0 || analyzeDepth > engine_max_depth()) {
+                printf("Invalid analysis depth: %s\n", argv[i]);
+                return 1;
+            }
+        } else if ((strcmp(argv[i], "--engine-a") == 0 || strcmp(argv[i], "--engine-b") == 0) && i + 1 < argc) {
+            // 自对弈双方的引擎设置
+            EngineSpec *spec = &selfplay.engines[argv[i][9] == 'a' ? 0 : 1];
+            if (parseEngineSpec(argv[++i], spec) != 0) {
+                printf("Invalid engine settings: %s\n", argv[i]);
+                return 1;
+            }
         } else {
             printf("Unknown parameter.\nUse -h to view help information, or -v to view version information.\n");
             return 1;
         }
     }
 
-    playGame();
-    return 0;
+    if (analyzePath != NULL) {
+        AnalyzeConfig analyze;
+        analyze.path = analyzePath;
+        analyze.size = size;
+        analyze.depth = analyzeDepth;
+        analyze.jobs = selfplay.jobs;
+        analyze.hashMegabytes = hashMegabytes;
+        return runAnalyze(&analyze);
+    }
+
+    // 自对弈和人机、双人对局都可以保存棋谱
+    if (recordPath != NULL && !protocol && benchDepth == 0 && bookSource == NULL && servePort == 0) {
+        gameRecord = recordOpenWriter(recordPath);
+        if (gameRecord == NULL) {
+            printf("Cannot open the game record file %s\n", recordPath);
+            return 1;
+        }
+    }
+
+    if (selfplay.games > 0) {
+        selfplay.size = size;
+        selfplay.hashMegabytes = hashMegabytes;
+        selfplay.record = gameRecord;
+        int status = runSelfplay(&selfplay);
+        if (recordCloseWriter(gameRecord) != 0) {
+            printf("Cannot write the game record file %s\n", recordPath);
+            status = 1;
+        }
+        return status;
+    }
+
+    aiEngine = engine_new_size(size);
+    if (aiEngine == NULL) {
+        printf("Failed to create the game engine.\n");
+        return 1;
+    }
+    engine_set_depth(aiEngine, depth);
+    engine_set_time_limit(aiEngine, timeLimitMs);
+    if (engine_set_hash_size(aiEngine, hashMegabytes) != 0) {
+        printf("Failed to allocate %zu MB for the hash table.\n", hashMegabytes);
+        engine_free(aiEngine);
+        return 1;
+    }
+    if (engine_set_threads(aiEngine, threads) != 0) {
+        printf("Failed to start %d search threads.\n", threads);
+        engine_free(aiEngine);
+        return 1;
+    }
+
+    if (bookSource != NULL) {
+        int status = buildBook(aiEngine, bookSource, bookPath);
+        engine_free(aiEngine);
+        return status;
+    }
+
+    // 开局库映射进内存后一直用到程序结束
+    Book *book = NULL;
+    if (bookPath != NULL) {
+        book = bookOpen(bookPath);
+        if (book == NULL) {
+            printf("Cannot open the opening book %s\n", bookPath);
+            engine_free(aiEngine);
+            return 1;
+        }
+        engine_set_book(aiEngine, book);
+    }
+
+    if (servePort > 0) {
+        ServerConfig server;
+        server.port = servePort;
+        server.size = size;
+        server.clients = serveClients;
+        server.jobs = selfplay.jobs;
+        server.moveMs = timeLimitMs > 0 ? timeLimitMs : SERVER_DEFAULT_MOVE_MS;
+        server.gameMegabytes = hashGiven ? hashMegabytes : SERVER_DEFAULT_GAME_MB;
+        server.book = book;
+        engine_free(aiEngine);
+        int status = runServer(&server);
+        bookClose(book);
+        return status;
+    }
+
+    int status = 0;
+    if (protocol) {
+        status = runProtocol(aiEngine, "name=\"gobang\", version=\"" VERSION "\", author=\"" AUTHOR "\", www=\"" WEBSITE "\"");
+    } else if (benchDepth > 0) {
+        status = runBench(aiEngine, benchDepth);
+    } else {
+        screen = screenNew(diffScreen);
+        if (screen == NULL) {
+            printf("Out of memory.\n");
+            status = 1;
+        } else {
+            playGame();
+            screenFree(screen);
+        }
+    }
+    engine_free(aiEngine);
+    bookClose(book);
+    if (recordCloseWriter(gameRecord) != 0) {
+        printf("Cannot write the game record file %s\n", recordPath);
+        status = 1;
+    }
+    return status;
 }
@@ -0,0 +1,143 @@
+/*
+ * 五子棋游戏 - 线程池
+ * 版权所有 (C) 2024 [大龙软件 bigdragonsoft.com]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "pool.h"
+
+typedef struct {
+    PoolTask task;
+    void *arg;
+} PoolJob;
+
+struct ThreadPool {
+    pthread_mutex_t lock;
+    pthread_cond_t notEmpty;  // 有新任务或要求退出
+    pthread_cond_t notFull;   // 队列有空位
+    pthread_cond_t idle;      // 所有任务都已完成
+    PoolJob *queue;           // 环形队列
+    int queueSize;
+    int head;
+    int count;                // 队列中的任务数
+    int running;              // 正在执行的任务数
+    int shutdown;
+    int threads;
+    pthread_t *workers;
+};
+
+/**
+ * @brief 工作线程主循环
+ * 
+ * @param arg 线程池
+ * @return void* 总是 NULL
+ */
+static void *poolWorker(void *arg) {
+    ThreadPool *pool = arg;
+
+    pthread_mutex_lock(&pool->lock);
+    while (1) {
+        while (pool->count == 0 && !pool->shutdown) {
+            pthread_cond_wait(&pool->notEmpty, &pool->lock);
+        }
+        if (pool->count == 0 && pool->shutdown) break;
+
+        PoolJob job = pool->queue[pool->head];
+        pool->head = (pool->head + 1) % pool->queueSize;
+        pool->count--;
+        pool->running++;
+        pthread_cond_signal(&pool->notFull);
+        pthread_mutex_unlock(&pool->lock);
+
+        job.task(job.arg);
+
+        pthread_mutex_lock(&pool->lock);
+        pool->running--;
+        if (pool->count == 0 && pool->running == 0) {
+            pthread_cond_broadcast(&pool->idle);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+ThreadPool *poolCreate(int threads, int queueSize) {
+    if (threads < 1 || queueSize < 1) return NULL;
+
+    ThreadPool *pool = calloc(1, sizeof(ThreadPool));
+    if (pool == NULL) return NULL;
+    pool->queue = calloc(queueSize, sizeof(PoolJob));
+    pool->workers = calloc(threads, sizeof(pthread_t));
+    if (pool->queue == NULL || pool->workers == NULL) {
+        free(pool->queue);
+        free(pool->workers);
+        free(pool);
+        return NULL;
+    }
+    pool->queueSize = queueSize;
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->notEmpty, NULL);
+    pthread_cond_init(&pool->notFull, NULL);
+    pthread_cond_init(&pool->idle, NULL);
+
+    for (int i = 0; i < threads; i++) {
+        if (pthread_create(&pool->workers[i], NULL, poolWorker, pool) != 0) {
+            break;
+        }
+        pool->threads++;
+    }
+    if (pool->threads == 0) {
+        poolDestroy(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+void poolSubmit(ThreadPool *pool, PoolTask task, void *arg) {
+    pthread_mutex_lock(&pool->lock);
+    while (pool->count == pool->queueSize) {
+        pthread_cond_wait(&pool->notFull, &pool->lock);
+    }
+    pool->queue[(pool->head + pool->count) % pool->queueSize] = (PoolJob){ task, arg };
+    pool->count++;
+    pthread_cond_signal(&pool->notEmpty);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void poolWait(ThreadPool *pool) {
+    pthread_mutex_lock(&pool->lock);
+    while (pool->count > 0 || pool->running > 0) {
+        pthread_cond_wait(&pool->idle, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+int poolThreads(const ThreadPool *pool) {
+    return pool->threads;
+}
+
+void poolDestroy(ThreadPool *pool) {
+    if (pool == NULL) return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->notEmpty);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->threads; i++) {
+        pthread_join(pool->workers[i], NULL);
+    }
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->notEmpty);
+    pthread_cond_destroy(&pool->notFull);
+    pthread_cond_destroy(&pool->idle);
+    free(pool->queue);
+    free(pool->workers);
+    free(pool);
+}
@@ -0,0 +1,55 @@
+/*
+ * 五子棋游戏 - 线程池
+ * 版权所有 (C) 2024 [大龙软件 bigdragonsoft.com]
+ *
+ * 固定数量的工作线程和固定容量的任务队列，创建后不再分配内存。
+ */
+
+#ifndef GOBANG_POOL_H
+#define GOBANG_POOL_H
+
+typedef struct ThreadPool ThreadPool;
+
+typedef void (*PoolTask)(void *arg);
+
+/**
+ * @brief 创建线程池
+ * 
+ * @param threads 工作线程数
+ * @param queueSize 任务队列容量
+ * @return ThreadPool* 成功返回线程池，失败返回 NULL
+ */
+ThreadPool *poolCreate(int threads, int queueSize);
+
+/**
+ * @brief 提交任务，队列满时阻塞直到有空位
+ * 
+ * @param pool 线程池
+ * @param task 任务函数
+ * @param arg 任务参数
+ */
+void poolSubmit(ThreadPool *pool, PoolTask task, void *arg);
+
+/**
+ * @brief 等待所有已提交的任务执行完毕
+ * 
+ * @param pool 线程池
+ */
+void poolWait(ThreadPool *pool);
+
+/**
+ * @brief 取工作线程数
+ * 
+ * @param pool 线程池
+ * @return int 工作线程数
+ */
+int poolThreads(const ThreadPool *pool);
+
+/**
+ * @brief 等待任务完成后结束所有工作线程并释放线程池
+ * 
+ * @param pool 线程池，可以为 NULL
+ */
+void poolDestroy(ThreadPool *pool);
+
+#endif
@@ -0,0 +1,226 @@
+/*
+ * 五子棋游戏 - Piskvork/Gomocup 协议
+ * 版权所有 (C) 2024 [大龙软件 bigdragonsoft.com]
+ *
+ * 协议中的坐标为 "x,y"，x 为列号，y 为行号，都从0开始。
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "protocol.h"
+
+#define PROTOCOL_LINE 256
+#define TIME_MARGIN_MS 50     // 每步留给通信和收尾的时间
+#define MOVES_LEFT_GUESS 20   // 按整局剩余时间分配时，假定还要走的步数
+
+// 协议发来的限制
+typedef struct {
+    long turnMs;    // 每步时限（毫秒），-1 表示未设置
+    long leftMs;    // 整局剩余时间（毫秒），-1 表示未设置
+    long hashMb;    // 按内存上限设置的置换表大小（MB），0 表示未设置
+} Limits;
+
+/**
+ * @brief 按协议发来的时间限制设置每步思考时间
+ * 
+ * @param e 引擎
+ * @param limits 协议限制
+ */
+static void applyTimeLimit(engine_t *e, const Limits *limits) {
+    long ms = limits->turnMs;
+    if (limits->leftMs >= 0) {
+        long share = limits->leftMs / MOVES_LEFT_GUESS;
+        if (ms < 0 || share < ms) ms = share;
+    }
+    if (ms < 0) {
+        return;  // 没有时间限制，按固定深度搜索
+    }
+    ms -= TIME_MARGIN_MS;
+    engine_set_time_limit(e, ms > 1 ? (int)ms : 1);
+}
+
+/**
+ * @brief 为轮到的一方搜索并落子，回答 "x,y"
+ * 
+ * @param e 引擎
+ * @param limits 协议限制
+ */
+static void playMove(engine_t *e, const Limits *limits) {
+    engine_result_t result;
+    applyTimeLimit(e, limits);
+    if (engine_search(e, &result) != 0) {
+        printf("ERROR board is full\n");
+        return;
+    }
+    engine_make_move(e, result.row, result.col);
+    printf("%d,%d\n", result.col, result.row);
+}
+
+/**
+ * @brief 解析 "x,y" 坐标
+ * 
+ * @param text 坐标文本
+ * @param size 棋盘边长
+ * @param row 输出：行号
+ * @param col 输出：列号
+ * @return int 成功返回0，格式不对或超出棋盘返回-1
+ */
+static int parseMove(const char *text, int size, int *row, int *col) {
+    int x, y;
+    if (sscanf(text, " %d , %d", &x, &y) != 2) return -1;
+    if (x < 0 || x >= size || y < 0 || y >= size) return -1;
+    *row = y;
+    *col = x;
+    return 0;
+}
+
+/**
+ * @brief 读取 BOARD 命令之后直到 DONE 的棋子并摆到棋盘上
+ * 
+ * 各行为 "x,y,who"，who 为1表示己方、2表示对方。棋子的先后顺序不影响局面，
+ * 按双方交替的顺序摆放，轮到己方走：双方棋子数相同时己方为黑，对方多一子时己方为白。
+ * 
+ * @param e 引擎
+ * @return int 成功返回0，局面不合法返回-1
+ */
+static int readBoard(engine_t *e) {
+    int stones[2][ENGINE_MAX_SIZE * ENGINE_MAX_SIZE][2];  // [己方/对方][序号][行, 列]
+    int counts[2] = {0, 0};
+    int size = engine_size(e);
+    int valid = 1;
+    char line[PROTOCOL_LINE];
+
+    while (fgets(line, sizeof(line), stdin) != NULL) {
+        int x, y, who;
+        if (strncmp(line, "DONE", 4) == 0) break;
+        if (sscanf(line, " %d , %d , %d", &x, &y, &who) != 3 ||
+            x < 0 || x >= size || y < 0 || y >= size || (who != 1 && who != 2) ||
+            counts[who - 1] >= size * size) {
+            valid = 0;
+            continue;
+        }
+        stones[who - 1][counts[who - 1]][0] = y;
+        stones[who - 1][counts[who - 1]][1] = x;
+        counts[who - 1]++;
+    }
+
+    engine_init(e);
+    if (!valid || (counts[1] != counts[0] && counts[1] != counts[0] + 1)) {
+        return -1;
+    }
+    // 先手一方：双方子数相同时为己方（下一步轮到己方走黑），否则为对方
+    int first = counts[0] == counts[1] ? 0 : 1;
+    for (int k = 0; k < counts[0] + counts[1]; k++) {
+        int side = k % 2 == 0 ? first : 1 - first;
+        const int *stone = stones[side][k / 2];
+        if (engine_make_move(e, stone[0], stone[1]) != 0) {
+            engine_init(e);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief 处理 INFO 命令
+ * 
+ * @param e 引擎
+ * @param args 命令参数，如 "timeout_turn 5000"
+ * @param limits 协议限制
+ */
+static void handleInfo(engine_t *e, const char *args, Limits *limits) {
+    char key[64];
+    long value;
+    if (sscanf(args, "%63s %ld", key, &value) != 2) return;
+
+    if (strcmp(key, "timeout_turn") == 0) {
+        limits->turnMs = value;
+    } else if (strcmp(key, "time_left") == 0) {
+        limits->leftMs = value;
+    } else if (strcmp(key, "max_memory") == 0 && value > 0) {
+        // 置换表用一半的内存预算，其余留给程序本身和搜索线程
+        long megabytes = value / 2 / (1024 * 1024);
+        if (megabytes < 1) megabytes = 1;
+        if (megabytes != limits->hashMb && engine_set_hash_size(e, megabytes) == 0) {
+            limits->hashMb = megabytes;
+        }
+    }
+}
+
+int runProtocol(engine_t *e, const char *about) {
+    Limits limits = {-1, -1, 0};
+    char line[PROTOCOL_LINE];
+
+    // 对局管理程序通过管道读取回答，每行都要立即送出
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    engine_init(e);
+
+    while (fgets(line, sizeof(line), stdin) != NULL) {
+        line[strcspn(line, "\r\n")] = '\0';
+
+        // 命令名不区分大小写，与参数以空白分隔
+        char command[32];
+        int length = 0;
+        const char *p = line;
+        while (isspace((unsigned char)*p)) p++;
+        while (*p != '\0' && !isspace((unsigned char)*p) && length < (int)sizeof(command) - 1) {
+            command[length++] = toupper((unsigned char)*p++);
+        }
+        command[length] = '\0';
+        const char *args = p;
+
+        int row, col;
+        if (length == 0) {
+            continue;
+        } else if (strcmp(command, "START") == 0) {
+            // 换尺寸时保留搜索设置，按新尺寸开始新的一局
+            if (engine_set_size(e, atoi(args)) != 0) {
+                printf("ERROR unsupported size, only 15, 19 and 20 are supported\n");
+            } else {
+                printf("OK\n");
+            }
+        } else if (strcmp(command, "RESTART") == 0) {
+            engine_init(e);
+            printf("OK\n");
+        } else if (strcmp(command, "BEGIN") == 0) {
+            playMove(e, &limits);
+        } else if (strcmp(command, "TURN") == 0) {
+            if (parseMove(args, engine_size(e), &row, &col) != 0 || engine_make_move(e, row, col) != 0) {
+                printf("ERROR invalid move %s\n", args);
+            } else {
+                playMove(e, &limits);
+            }
+        } else if (strcmp(command, "BOARD") == 0) {
+            if (readBoard(e) != 0) {
+                printf("ERROR invalid board\n");
+            } else {
+                playMove(e, &limits);
+            }
+        } else if (strcmp(command, "TAKEBACK") == 0) {
+            // 只能收回最后一步，坐标不符时不动棋盘，免得与管理程序的棋盘不一致
+            int lastRow, lastCol;
+            if (parseMove(args, engine_size(e), &row, &col) != 0) {
+                printf("ERROR invalid move %s\n", args);
+            } else if (engine_last_move(e, &lastRow, &lastCol) != 0 ||
+                       lastRow != row || lastCol != col || engine_undo(e) != 0) {
+                printf("ERROR %s is not the last move\n", args);
+            } else {
+                printf("OK\n");
+            }
+        } else if (strcmp(command, "INFO") == 0) {
+            handleInfo(e, args, &limits);
+        } else if (strcmp(command, "ABOUT") == 0) {
+            printf("%s\n", about);
+        } else if (strcmp(command, "END") == 0) {
+            break;
+        } else {
+            printf("UNKNOWN command %s\n", command);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,22 @@
+/*
+ * 五子棋游戏 - Piskvork/Gomocup 协议
+ * 版权所有 (C) 2024 [大龙软件 bigdragonsoft.com]
+ *
+ * 无界面模式：从标准输入逐行读取命令，在标准输出回答，供对局管理程序调用。
+ */
+
+#ifndef GOBANG_PROTOCOL_H
+#define GOBANG_PROTOCOL_H
+
+#include "engine.h"
+
+/**
+ * @brief 运行协议主循环，直到收到 END 或输入结束
+ * 
+ * @param e 引擎，按协议发来的时间和内存限制调整其设置
+ * @param about ABOUT 命令的回答，如 name="gobang", version="0.1"
+ * @return int 程序退出状态
+ */
+int runProtocol(engine_t *e, const char *about);
+
+#endif
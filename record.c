@@ -0,0 +1,175 @@
+/*
+ * 五子棋游戏 - 棋谱文件
+ * 版权所有 (C) 2024 [大龙软件 bigdragonsoft.com]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "record.h"
+
+#define RECORD_BUFFER (64 * 1024)  // 读写文件的缓冲区大小
+#define GAME_HEADER 4              // 局头：边长、胜方、两字节步数
+
+struct RecordWriter {
+    FILE *fp;
+};
+
+struct RecordReader {
+    FILE *fp;
+};
+
+/**
+ * @brief 每步着法占的字节数
+ * 
+ * @param size 棋盘边长
+ * @return int 1 或 2
+ */
+static int moveBytes(int size) {
+    return size * size <= 256 ? 1 : 2;
+}
+
+RecordWriter *recordOpenWriter(const char *path) {
+    FILE *fp = fopen(path, "a+b");
+    if (fp == NULL) {
+        return NULL;
+    }
+    // setvbuf 必须在对文件做任何操作之前调用
+    setvbuf(fp, NULL, _IOFBF, RECORD_BUFFER);
+    // 追加方式打开时读取位置可以移动，写入总在文件末尾
+    char magic[8];
+    fseek(fp, 0, SEEK_END);
+    if (ftell(fp) == 0) {
+        if (fwrite(RECORD_MAGIC, sizeof(magic), 1, fp) != 1) {
+            fclose(fp);
+            return NULL;
+        }
+    } else {
+        fseek(fp, 0, SEEK_SET);
+        if (fread(magic, sizeof(magic), 1, fp) != 1 || memcmp(magic, RECORD_MAGIC, sizeof(magic)) != 0) {
+            fclose(fp);
+            return NULL;
+        }
+        // 读写交替之间须定位一次，随后的 recordWrite() 才能直接写入
+        fseek(fp, 0, SEEK_END);
+    }
+
+    RecordWriter *writer = malloc(sizeof(RecordWriter));
+    if (writer == NULL) {
+        fclose(fp);
+        return NULL;
+    }
+    writer->fp = fp;
+    return writer;
+}
+
+int recordWrite(RecordWriter *writer, const GameRecord *game) {
+    if (game->size < 1 || game->size > ENGINE_MAX_SIZE ||
+        game->moveCount < 0 || game->moveCount > game->size * game->size) {
+        return -1;
+    }
+
+    uint8_t buffer[GAME_HEADER + 2 * RECORD_MAX_MOVES];
+    int bytes = moveBytes(game->size);
+    int length = GAME_HEADER;
+    buffer[0] = (uint8_t)game->size;
+    buffer[1] = (uint8_t)game->winner;
+    buffer[2] = (uint8_t)(game->moveCount & 0xFF);
+    buffer[3] = (uint8_t)(game->moveCount >> 8);
+    for (int i = 0; i < game->moveCount; i++) {
+        if (game->rows[i] >= game->size || game->cols[i] >= game->size) {
+            return -1;
+        }
+        int cell = game->rows[i] * game->size + game->cols[i];
+        buffer[length++] = (uint8_t)(cell & 0xFF);
+        if (bytes == 2) {
+            buffer[length++] = (uint8_t)(cell >> 8);
+        }
+    }
+    return fwrite(buffer, length, 1, writer->fp) == 1 ? 0 : -1;
+}
+
+int recordCloseWriter(RecordWriter *writer) {
+    if (writer == NULL) {
+        return 0;
+    }
+    int status = fclose(writer->fp) == 0 ? 0 : -1;
+    free(writer);
+    return status;
+}
+
+RecordReader *recordOpenReader(const char *path) {
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        return NULL;
+    }
+    // setvbuf 必须在对文件做任何操作之前调用
+    setvbuf(fp, NULL, _IOFBF, RECORD_BUFFER);
+    char magic[8];
+    if (fread(magic, sizeof(magic), 1, fp) != 1 || memcmp(magic, RECORD_MAGIC, sizeof(magic)) != 0) {
+        fclose(fp);
+        return NULL;
+    }
+
+    RecordReader *reader = malloc(sizeof(RecordReader));
+    if (reader == NULL) {
+        fclose(fp);
+        return NULL;
+    }
+    reader->fp = fp;
+    return reader;
+}
+
+int recordRead(RecordReader *reader, GameRecord *game) {
+    uint8_t header[GAME_HEADER];
+    size_t got = fread(header, 1, GAME_HEADER, reader->fp);
+    if (got == 0) {
+        return 0;
+    }
+    if (got != GAME_HEADER) {
+        return -1;
+    }
+    game->size = header[0];
+    game->winner = header[1];
+    game->moveCount = header[2] | header[3] << 8;
+    if (game->size < 1 || game->size > ENGINE_MAX_SIZE ||
+        (game->winner != EMPTY && game->winner != BLACK && game->winner != WHITE) ||
+        game->moveCount > game->size * game->size) {
+        return -1;
+    }
+
+    uint8_t moves[2 * RECORD_MAX_MOVES];
+    int bytes = moveBytes(game->size);
+    if (fread(moves, bytes, game->moveCount, reader->fp) != (size_t)game->moveCount) {
+        return -1;
+    }
+    for (int i = 0; i < game->moveCount; i++) {
+        int cell = bytes == 1 ? moves[i] : moves[2 * i] | moves[2 * i + 1] << 8;
+        if (cell >= game->size * game->size) {
+            return -1;
+        }
+        game->rows[i] = (uint8_t)(cell / game->size);
+        game->cols[i] = (uint8_t)(cell % game->size);
+    }
+    return 1;
+}
+
+void recordCloseReader(RecordReader *reader) {
+    if (reader == NULL) {
+        return;
+    }
+    fclose(reader->fp);
+    free(reader);
+}
+
+int recordIsFile(const char *path) {
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        return 0;
+    }
+    char magic[8];
+    int match = fread(magic, sizeof(magic), 1, fp) == 1 && memcmp(magic, RECORD_MAGIC, sizeof(magic)) == 0;
+    fclose(fp);
+    return match;
+}
@@ -0,0 +1,91 @@
+/*
+ * 五子棋游戏 - 棋谱文件
+ * 版权所有 (C) 2024 [大龙软件 bigdragonsoft.com]
+ *
+ * 棋谱文件以8字节标识开头，后面是一局接一局的对局记录，可以随时在末尾追加。
+ * 每局4字节的局头（棋盘边长、胜方、步数）后跟着法，每步是 row * 棋盘边长 + col，
+ * 棋盘不超过 16x16 时占1字节，否则占2字节。多字节的数一律按小端存放。
+ */
+
+#ifndef GOBANG_RECORD_H
+#define GOBANG_RECORD_H
+
+#include <stdint.h>
+
+#include "engine.h"
+
+#define RECORD_MAGIC "GOBANGGR"  // 文件头的8字节标识
+#define RECORD_MAX_MOVES (ENGINE_MAX_SIZE * ENGINE_MAX_SIZE)
+
+/**
+ * 一局对局
+ */
+typedef struct {
+    int size;                          // 棋盘边长
+    int winner;                        // BLACK、WHITE，和棋或未下完为 EMPTY
+    int moveCount;                     // 步数
+    uint8_t rows[RECORD_MAX_MOVES];    // 各步的行号，黑方先走
+    uint8_t cols[RECORD_MAX_MOVES];    // 各步的列号
+} GameRecord;
+
+typedef struct RecordWriter RecordWriter;
+typedef struct RecordReader RecordReader;
+
+/**
+ * @brief 打开棋谱文件用于追加，文件不存在时新建
+ * 
+ * @param path 文件路径
+ * @return RecordWriter* 成功返回写入器，无法打开或不是棋谱文件返回 NULL
+ */
+RecordWriter *recordOpenWriter(const char *path);
+
+/**
+ * @brief 在文件末尾追加一局
+ * 
+ * @param writer 写入器
+ * @param game 对局
+ * @return int 成功返回0，对局不合法或写入失败返回-1
+ */
+int recordWrite(RecordWriter *writer, const GameRecord *game);
+
+/**
+ * @brief 写出缓冲的数据并关闭文件
+ * 
+ * @param writer 写入器，可以为 NULL
+ * @return int 成功返回0，写入失败返回-1
+ */
+int recordCloseWriter(RecordWriter *writer);
+
+/**
+ * @brief 打开棋谱文件用于顺序读取
+ * 
+ * @param path 文件路径
+ * @return RecordReader* 成功返回读取器，无法打开或不是棋谱文件返回 NULL
+ */
+RecordReader *recordOpenReader(const char *path);
+
+/**
+ * @brief 读出下一局
+ * 
+ * @param reader 读取器
+ * @param game 输出：对局
+ * @return int 读到一局返回1，文件结束返回0，记录损坏返回-1
+ */
+int recordRead(RecordReader *reader, GameRecord *game);
+
+/**
+ * @brief 关闭读取器
+ * 
+ * @param reader 读取器，可以为 NULL
+ */
+void recordCloseReader(RecordReader *reader);
+
+/**
+ * @brief 判断文件是否是棋谱文件（以 RECORD_MAGIC 开头）
+ * 
+ * @param path 文件路径
+ * @return int 是返回1，否则返回0
+ */
+int recordIsFile(const char *path);
+
+#endif
@@ -0,0 +1,171 @@
+/*
+ * 五子棋游戏 - 控制台画面
+ * 版权所有 (C) 2024 [大龙软件 bigdragonsoft.com]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+#include "render.h"
+
+#define FRAME_BUFFER (16 * 1024)  // 一帧的最大字节数，20x20 的棋盘约需 2KB
+#define OUTPUT_BUFFER (FRAME_BUFFER * 2)  // 差量输出每行另加光标定位和清行序列
+#define SCREEN_MARGIN 8           // 差量重画时帧下方至少留出的行数，供提示和搜索信息使用
+
+#define ANSI_CLEAR "\033[H\033[2J"  // 光标回到左上角并清屏
+#define ANSI_CLEAR_LINE "\033[K"    // 清除光标到行尾
+#define ANSI_CLEAR_BELOW "\033[J"   // 清除光标到屏幕末尾
+
+struct Screen {
+    int diff;                      // 为1时只重画变化的行
+    char frame[FRAME_BUFFER];      // 正在生成的一帧
+    size_t frameLength;
+    char shown[FRAME_BUFFER];      // 屏幕上的上一帧，为空表示需要整帧重画
+    size_t shownLength;
+    char output[OUTPUT_BUFFER];    // 实际写到终端的字节
+    size_t outputLength;
+};
+
+Screen *screenNew(int diff) {
+    Screen *s = malloc(sizeof(Screen));
+    if (s == NULL) {
+        return NULL;
+    }
+    s->diff = diff;
+    s->frameLength = 0;
+    s->shownLength = 0;
+    s->outputLength = 0;
+    return s;
+}
+
+void screenFree(Screen *s) {
+    free(s);
+}
+
+void screenBegin(Screen *s) {
+    s->frameLength = 0;
+}
+
+void screenPrintf(Screen *s, const char *format, ...) {
+    size_t room = FRAME_BUFFER - s->frameLength;
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(s->frame + s->frameLength, room, format, args);
+    va_end(args);
+    if (n < 0) return;
+    s->frameLength += (size_t)n < room ? (size_t)n : room - 1;
+}
+
+void screenInvalidate(Screen *s) {
+    s->shownLength = 0;
+}
+
+/**
+ * @brief 向输出缓冲区追加字节，放不下的部分丢弃
+ */
+static void emit(Screen *s, const char *data, size_t length) {
+    size_t room = OUTPUT_BUFFER - s->outputLength;
+    if (length > room) length = room;
+    memcpy(s->output + s->outputLength, data, length);
+    s->outputLength += length;
+}
+
+/**
+ * @brief 统计一段文字的行数（换行符个数）
+ */
+static int countLines(const char *text, size_t length) {
+    int lines = 0;
+    for (size_t k = 0; k < length; k++) {
+        if (text[k] == '\n') lines++;
+    }
+    return lines;
+}
+
+/**
+ * @brief 判断能否差量重画：上一帧之后的输出不能让终端滚屏，否则行号对不上
+ * 
+ * @param lines 新帧的行数
+ * @return int 可以差量重画返回1
+ */
+static int canDiff(const Screen *s, int lines) {
+    struct winsize size;
+    if (!s->diff || s->shownLength == 0) return 0;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) != 0 || size.ws_row == 0) return 0;
+    int shownLines = countLines(s->shown, s->shownLength);
+    int tallest = lines > shownLines ? lines : shownLines;
+    return tallest + SCREEN_MARGIN <= size.ws_row;
+}
+
+/**
+ * @brief 逐行比较新帧与上一帧，只输出不同的行
+ * 
+ * 每行先把光标移到行首再写出整行，因此不依赖棋子符号在终端上的显示宽度。
+ */
+static void emitChangedLines(Screen *s) {
+    const char *next = s->frame, *nextEnd = s->frame + s->frameLength;
+    const char *old = s->shown, *oldEnd = s->shown + s->shownLength;
+    char position[32];
+    int line = 1;
+
+    while (next < nextEnd) {
+        const char *nextEol = memchr(next, '\n', (size_t)(nextEnd - next));
+        const char *oldEol = old < oldEnd ? memchr(old, '\n', (size_t)(oldEnd - old)) : NULL;
+        size_t nextLength = nextEol ? (size_t)(nextEol - next) : (size_t)(nextEnd - next);
+        size_t oldLength = oldEol ? (size_t)(oldEol - old) : (old < oldEnd ? (size_t)(oldEnd - old) : 0);
+
+        if (old >= oldEnd || nextLength != oldLength || memcmp(next, old, nextLength) != 0) {
+            int n = snprintf(position, sizeof(position), "\033[%d;1H", line);
+            emit(s, position, (size_t)n);
+            emit(s, next, nextLength);
+            emit(s, ANSI_CLEAR_LINE, strlen(ANSI_CLEAR_LINE));
+        }
+        next += nextLength + (nextEol ? 1 : 0);
+        old = old < oldEnd ? old + oldLength + (oldEol ? 1 : 0) : oldEnd;
+        line++;
+    }
+
+    // 光标移到帧的下一行，清掉上一帧更长的部分和之后打印的提示
+    int n = snprintf(position, sizeof(position), "\033[%d;1H", line);
+    emit(s, position, (size_t)n);
+    emit(s, ANSI_CLEAR_BELOW, strlen(ANSI_CLEAR_BELOW));
+}
+
+/**
+ * @brief 把缓冲区一次写到终端，只有被信号打断或写了一部分时才继续写剩下的
+ */
+static int writeAll(const char *data, size_t length) {
+    while (length > 0) {
+        ssize_t n = write(STDOUT_FILENO, data, length);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        data += n;
+        length -= (size_t)n;
+    }
+    return 0;
+}
+
+int screenShow(Screen *s) {
+    s->outputLength = 0;
+    if (canDiff(s, countLines(s->frame, s->frameLength))) {
+        emitChangedLines(s);
+    } else {
+        emit(s, ANSI_CLEAR, strlen(ANSI_CLEAR));
+        emit(s, s->frame, s->frameLength);
+    }
+
+    memcpy(s->shown, s->frame, s->frameLength);
+    s->shownLength = s->frameLength;
+
+    // stdout 中还没写出的文字必须先于这一帧到达终端
+    fflush(stdout);
+    return writeAll(s->output, s->outputLength);
+}
@@ -0,0 +1,67 @@
+/*
+ * 五子棋游戏 - 控制台画面
+ * 版权所有 (C) 2024 [大龙软件 bigdragonsoft.com]
+ *
+ * 一帧画面先整个写进缓冲区，再用一次 write() 输出。清屏用 ANSI 转义序列，
+ * 不再调用外部命令。打开差量重画时只重写与上一帧不同的行。
+ */
+
+#ifndef GOBANG_RENDER_H
+#define GOBANG_RENDER_H
+
+typedef struct Screen Screen;
+
+/**
+ * @brief 创建画面
+ * 
+ * @param diff 为1时只重画与上一帧不同的行，为0时每帧清屏后整帧重画
+ * @return Screen* 成功返回画面，内存不足返回 NULL
+ */
+Screen *screenNew(int diff);
+
+/**
+ * @brief 释放画面
+ * 
+ * @param s 画面，可以为 NULL
+ */
+void screenFree(Screen *s);
+
+/**
+ * @brief 开始新的一帧，清空缓冲区
+ * 
+ * @param s 画面
+ */
+void screenBegin(Screen *s);
+
+/**
+ * @brief 按 printf 的格式向当前帧追加文字，超出缓冲区的部分被截掉
+ * 
+ * @param s 画面
+ * @param format 格式
+ */
+void screenPrintf(Screen *s, const char *format, ...)
+#ifdef __GNUC__
+    __attribute__((format(printf, 2, 3)))
+#endif
+    ;
+
+/**
+ * @brief 输出当前帧
+ * 
+ * 先写出 stdout 中缓冲的文字，再用一次 write() 输出整帧。差量重画时只输出变化的行，
+ * 并清除上一帧之后打印的文字；屏幕上没有上一帧、终端行数不够或输出不是终端时整帧重画。
+ * 输出后光标停在帧的下一行行首。
+ * 
+ * @param s 画面
+ * @return int 成功返回0，写入失败返回-1
+ */
+int screenShow(Screen *s);
+
+/**
+ * @brief 下一帧整帧重画，用于屏幕被其他输出弄乱之后
+ * 
+ * @param s 画面
+ */
+void screenInvalidate(Screen *s);
+
+#endif
@@ -0,0 +1,321 @@
+/*
+ * 五子棋游戏 - 自对弈
+ * 版权所有 (C) 2024 [大龙软件 bigdragonsoft.com]
+ *
+ * 每两局为一组，用同一个随机开局，黑白互换，抵消先手优势。
+ * 每局各用两个新建的引擎，对局之间没有共享状态。
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+
+#include "selfplay.h"
+#include "pool.h"
+
+#define OPENING_STONES 3   // 随机开局的棋子数
+#define OPENING_RADIUS 2   // 随机开局的棋子离中心的最大距离
+#define MOVES_TEXT (ENGINE_MAX_SIZE * ENGINE_MAX_SIZE * 3 + 1)
+
+// 对局结果
+enum { RESULT_A, RESULT_B, RESULT_DRAW };
+
+// 所有对局共享的统计，输出和计数都在锁内进行
+typedef struct {
+    pthread_mutex_t lock;
+    int finished;
+    int results[3];   // 按 RESULT_A、RESULT_B、RESULT_DRAW 计数
+    int failed;       // 因内存不足没有下完的对局数
+    int unsaved;      // 没能写进棋谱文件的对局数
+} Tally;
+
+// 一局对局的任务参数
+typedef struct {
+    const SelfplayConfig *config;
+    Tally *tally;
+    int game;         // 对局编号，从0开始
+} GameTask;
+
+void defaultEngineSpec(EngineSpec *spec) {
+    memset(spec, 0, sizeof(*spec));
+    spec->depth = MEDIUM_DEPTH;
+    spec->threatNodes = -1;
+    spec->aspiration = -1;
+    spec->lmrMoves = -1;
+}
+
+int parseEngineSpec(const char *text, EngineSpec *spec) {
+    const char *p = text;
+    while (*p) {
+        char *end;
+        if (strncmp(p, "depth=", 6) == 0) {
+            long depth = strtol(p + 6, &end, 10);
+            if (end == p + 6 || depth < 1 || depth > engine_max_depth()) return -1;
+            spec->depth = (int)depth;
+        } else if (strncmp(p, "time=", 5) == 0) {
+            long ms = strtol(p + 5, &end, 10);
+            if (end == p + 5 || ms < 0) return -1;
+            spec->timeLimitMs = (int)ms;
+        } else if (strncmp(p, "threats=", 8) == 0) {
+            long nodes = strtol(p + 8, &end, 10);
+            if (end == p + 8 || nodes < 0) return -1;
+            spec->threatNodes = nodes;
+        } else if (strncmp(p, "aspiration=", 11) == 0) {
+            long window = strtol(p + 11, &end, 10);
+            if (end == p + 11 || window < 0) return -1;
+            spec->aspiration = (int)window;
+        } else if (strncmp(p, "lmr=", 4) == 0) {
+            long moves = strtol(p + 4, &end, 10);
+            if (end == p + 4 || moves < 0) return -1;
+            spec->lmrMoves = (int)moves;
+        } else if (strncmp(p, "weights=", 8) == 0) {
+            end = (char *)p + 7;
+            for (int k = 0; k < ENGINE_WEIGHT_COUNT; k++) {
+                const char *start = end + 1;
+                long weight = strtol(start, &end, 10);
+                if (end == start || weight < 0) return -1;
+                if (k < ENGINE_WEIGHT_COUNT - 1 && *end != '/') return -1;
+                spec->weights[k] = (int)weight;
+            }
+            spec->hasWeights = 1;
+        } else {
+            return -1;
+        }
+        if (*end == ',') {
+            end++;
+        } else if (*end != '\0') {
+            return -1;
+        }
+        p = end;
+    }
+    return 0;
+}
+
+/**
+ * @brief 按设置新建一个引擎
+ * 
+ * @param spec 引擎设置
+ * @param config 自对弈设置，提供棋盘尺寸和置换表大小
+ * @return engine_t* 成功返回引擎，内存不足返回 NULL
+ */
+static engine_t *createEngine(const EngineSpec *spec, const SelfplayConfig *config) {
+    engine_t *e = engine_new_size(config->size);
+    if (e == NULL) return NULL;
+    if (engine_set_hash_size(e, config->hashMegabytes) != 0) {
+        engine_free(e);
+        return NULL;
+    }
+    engine_set_depth(e, spec->depth);
+    engine_set_time_limit(e, spec->timeLimitMs);
+    if (spec->threatNodes >= 0) {
+        engine_set_threat_nodes(e, (unsigned long)spec->threatNodes);
+    }
+    if (spec->aspiration >= 0) {
+        engine_set_aspiration(e, spec->aspiration);
+    }
+    if (spec->lmrMoves >= 0) {
+        engine_set_lmr_moves(e, spec->lmrMoves);
+    }
+    if (spec->hasWeights) {
+        engine_set_weights(e, spec->weights);
+    }
+    return e;
+}
+
+/**
+ * @brief 取同一组对局共用的随机开局
+ * 
+ * 随机数只由组号决定，同样的设置每次运行得到同样的开局。
+ * 
+ * @param pair 组号
+ * @param size 棋盘边长
+ * @param rows 输出：OPENING_STONES 个行号
+ * @param cols 输出：OPENING_STONES 个列号
+ */
+static void pickOpening(int pair, int size, int rows[], int cols[]) {
+    unsigned long long state = 0x9E3779B97F4A7C15ULL * (unsigned long long)(pair + 1);
+    int center = size / 2;
+    int span = 2 * OPENING_RADIUS + 1;
+    for (int k = 0; k < OPENING_STONES; k++) {
+        int row, col, taken;
+        do {
+            // xorshift64
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            row = center - OPENING_RADIUS + (int)(state % span);
+            col = center - OPENING_RADIUS + (int)(state / span % span);
+            taken = 0;
+            for (int j = 0; j < k; j++) {
+                if (rows[j] == row && cols[j] == col) taken = 1;
+            }
+        } while (taken);
+        rows[k] = row;
+        cols[k] = col;
+    }
+}
+
+/**
+ * @brief 下完一局，在锁内输出一行 JSON 并计入统计
+ * 
+ * 偶数局 A 执黑，奇数局 B 执黑，两局的开局相同。
+ * 
+ * @param arg GameTask
+ */
+static void playGame(void *arg) {
+    GameTask *task = arg;
+    const SelfplayConfig *config = task->config;
+    int blackIsA = task->game % 2 == 0;
+    engine_t *engines[3] = { NULL, NULL, NULL };  // 按 BLACK、WHITE 取
+    char moves[MOVES_TEXT];
+    int length = 0;
+    int winner = EMPTY;
+    int rows[OPENING_STONES], cols[OPENING_STONES];
+    GameRecord record;
+
+    engines[BLACK] = createEngine(&config->engines[blackIsA ? 0 : 1], config);
+    engines[WHITE] = createEngine(&config->engines[blackIsA ? 1 : 0], config);
+    if (engines[BLACK] == NULL || engines[WHITE] == NULL) {
+        engine_free(engines[BLACK]);
+        engine_free(engines[WHITE]);
+        pthread_mutex_lock(&task->tally->lock);
+        task->tally->failed++;
+        pthread_mutex_unlock(&task->tally->lock);
+        return;
+    }
+
+    record.size = config->size;
+    record.moveCount = 0;
+    pickOpening(task->game / 2, config->size, rows, cols);
+    for (int k = 0; k < OPENING_STONES; k++) {
+        engine_make_move(engines[BLACK], rows[k], cols[k]);
+        engine_make_move(engines[WHITE], rows[k], cols[k]);
+        record.rows[record.moveCount] = (uint8_t)rows[k];
+        record.cols[record.moveCount++] = (uint8_t)cols[k];
+        length += sprintf(moves + length, "%s%c%c", k ? " " : "", bookCoordChar(rows[k]), bookCoordChar(cols[k]));
+    }
+
+    while (engine_move_count(engines[BLACK]) < config->size * config->size) {
+        int player = engine_to_move(engines[BLACK]);
+        engine_result_t result;
+        if (engine_search(engines[player], &result) != 0) break;
+        engine_make_move(engines[BLACK], result.row, result.col);
+        engine_make_move(engines[WHITE], result.row, result.col);
+        record.rows[record.moveCount] = (uint8_t)result.row;
+        record.cols[record.moveCount++] = (uint8_t)result.col;
+        length += sprintf(moves + length, " %c%c", bookCoordChar(result.row), bookCoordChar(result.col));
+        if (engine_check_win(engines[BLACK], result.row, result.col)) {
+            winner = player;
+            break;
+        }
+    }
+
+    int outcome = RESULT_DRAW;
+    if (winner != EMPTY) {
+        outcome = (winner == BLACK) == blackIsA ? RESULT_A : RESULT_B;
+    }
+    static const char *const resultText[] = { "1/2-1/2", "1-0", "0-1" };
+    static const char *const winnerText[] = { "null", "\"A\"", "\"B\"" };
+
+    pthread_mutex_lock(&task->tally->lock);
+    printf("{\"game\":%d,\"black\":\"%s\",\"white\":\"%s\",\"result\":\"%s\",\"winner\":%s,"
+           "\"plies\":%d,\"moves\":\"%s\"}\n",
+           task->game + 1, blackIsA ? "A" : "B", blackIsA ? "B" : "A", resultText[winner],
+           winnerText[outcome == RESULT_DRAW ? 0 : outcome + 1],
+           engine_move_count(engines[BLACK]), moves);
+    fflush(stdout);
+    record.winner = winner;
+    if (config->record != NULL && recordWrite(config->record, &record) != 0) {
+        task->tally->unsaved++;
+    }
+    task->tally->results[outcome]++;
+    task->tally->finished++;
+    pthread_mutex_unlock(&task->tally->lock);
+
+    engine_free(engines[BLACK]);
+    engine_free(engines[WHITE]);
+}
+
+/**
+ * @brief 由得分率换算 Elo 差
+ * 
+ * @param score 得分率，0 到 1 之间（不含两端）
+ * @return double Elo 差
+ */
+static double eloFromScore(double score) {
+    return 400.0 * log10(score / (1.0 - score));
+}
+
+/**
+ * @brief 输出 A 对 B 的胜负和 Elo 差，以及 95% 置信区间
+ * 
+ * @param tally 对局统计
+ */
+static void printSummary(const Tally *tally) {
+    int wins = tally->results[RESULT_A];
+    int losses = tally->results[RESULT_B];
+    int draws = tally->results[RESULT_DRAW];
+    int games = wins + losses + draws;
+
+    printf("# A vs B: +%d -%d =%d in %d games", wins, losses, draws, games);
+    if (tally->failed > 0) {
+        printf(" (%d not played: out of memory)", tally->failed);
+    }
+    printf("\n");
+    if (tally->unsaved > 0) {
+        printf("# %d games could not be written to the game record file\n", tally->unsaved);
+    }
+    if (games == 0) return;
+
+    double score = (wins + 0.5 * draws) / games;
+    printf("# score %.1f%%, ", 100.0 * score);
+    if (wins + draws == 0 || losses + draws == 0) {
+        printf("Elo difference unbounded (%s)\n", losses + draws == 0 ? "A won every game" : "B won every game");
+        return;
+    }
+
+    // 每局得分的标准差，按正态近似取 95% 区间
+    double variance = (wins * (1.0 - score) * (1.0 - score) + losses * score * score +
+                       draws * (0.5 - score) * (0.5 - score)) / games;
+    double margin = 1.96 * sqrt(variance / games);
+    double low = score - margin, high = score + margin;
+    printf("Elo difference %+.0f", eloFromScore(score));
+    if (low > 0.0 && high < 1.0) {
+        printf(" (95%%: %+.0f to %+.0f)\n", eloFromScore(low), eloFromScore(high));
+    } else {
+        printf(" (95%% interval unbounded)\n");
+    }
+}
+
+int runSelfplay(const SelfplayConfig *config) {
+    Tally tally;
+    memset(&tally, 0, sizeof(tally));
+    pthread_mutex_init(&tally.lock, NULL);
+
+    GameTask *tasks = malloc(sizeof(GameTask) * config->games);
+    ThreadPool *pool = tasks ? poolCreate(config->jobs, config->games) : NULL;
+    if (pool == NULL) {
+        printf("Cannot start %d self-play jobs\n", config->jobs);
+        free(tasks);
+        pthread_mutex_destroy(&tally.lock);
+        return 1;
+    }
+
+    for (int i = 0; i < config->games; i++) {
+        tasks[i].config = config;
+        tasks[i].tally = &tally;
+        tasks[i].game = i;
+        poolSubmit(pool, playGame, &tasks[i]);
+    }
+    poolWait(pool);
+    poolDestroy(pool);
+
+    printSummary(&tally);
+    free(tasks);
+    pthread_mutex_destroy(&tally.lock);
+    return tally.failed > 0 || tally.unsaved > 0 ? 1 : 0;
+}
@@ -0,0 +1,69 @@
+/*
+ * 五子棋游戏 - 自对弈
+ * 版权所有 (C) 2024 [大龙软件 bigdragonsoft.com]
+ *
+ * 两组引擎设置之间批量对局，多个对局在线程池中并行，
+ * 每局结束时输出一行 JSON，最后统计胜负和 Elo 差。
+ */
+
+#ifndef GOBANG_SELFPLAY_H
+#define GOBANG_SELFPLAY_H
+
+#include <stddef.h>
+
+#include "engine.h"
+#include "record.h"
+
+/**
+ * 一方引擎的设置
+ */
+typedef struct {
+    int depth;                         // 固定搜索深度
+    int timeLimitMs;                   // 每步思考时间，0 表示按固定深度
+    long threatNodes;                  // VCF/VCT 节点预算，-1 表示用引擎默认值
+    int aspiration;                    // 根节点搜索窗口半宽，-1 表示用引擎默认值
+    int lmrMoves;                      // 按完整深度搜索的着法数，-1 表示用引擎默认值
+    int hasWeights;                    // 为1时使用 weights
+    int weights[ENGINE_WEIGHT_COUNT];  // 评估权重，顺序见 ENGINE_WEIGHT_COUNT
+} EngineSpec;
+
+/**
+ * 一次自对弈的设置
+ */
+typedef struct {
+    int games;              // 对局数
+    int jobs;               // 并行的对局数
+    int size;               // 棋盘边长
+    size_t hashMegabytes;   // 每个引擎的置换表大小
+    EngineSpec engines[2];  // 引擎 A、B；A 在偶数局执黑，奇数局执白
+    RecordWriter *record;   // 不为 NULL 时每局结束后追加到该棋谱文件
+} SelfplayConfig;
+
+/**
+ * @brief 引擎设置的默认值：中等难度、不限时、默认权重
+ * 
+ * @param spec 输出：引擎设置
+ */
+void defaultEngineSpec(EngineSpec *spec);
+
+/**
+ * @brief 解析引擎设置
+ * 
+ * 格式为逗号分隔的 key=value：depth=N、time=MS、threats=NODES、aspiration=W、lmr=K、
+ * weights=W1/W2/W3/W4/W5/W6。未给出的项保持原值。
+ * 
+ * @param text 设置文本
+ * @param spec 输入输出：引擎设置
+ * @return int 成功返回0，格式不对返回-1
+ */
+int parseEngineSpec(const char *text, EngineSpec *spec);
+
+/**
+ * @brief 运行自对弈并输出结果
+ * 
+ * @param config 自对弈设置
+ * @return int 程序退出状态
+ */
+int runSelfplay(const SelfplayConfig *config);
+
+#endif
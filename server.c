@@ -0,0 +1,826 @@
+/*
+ * 五子棋游戏 - 网络对局服务器
+ * 版权所有 (C) 2024 [大龙软件 bigdragonsoft.com]
+ *
+ * 协议：每行一条命令，不分大小写，服务器每行一条回答。
+ *   HELP                 列出命令
+ *   NEW AI [BLACK|WHITE] 与电脑对局，默认执黑
+ *   NEW PVP              开一局双人对局，执黑，等对手 JOIN
+ *   JOIN N               加入第 N 局双人对局，执白
+ *   MOVE ROW COL         落子，行号、列号为从0开始的十进制数
+ *   BOARD                显示棋盘，. 为空，X 为黑子，O 为白子
+ *   LEAVE                离开当前对局
+ *   QUIT                 断开连接
+ * 服务器的通知：MOVE ROW COL（对方落子）、TURN（轮到你走）、START（对手已加入）、
+ * WIN BLACK|WHITE、DRAW、LEFT（对手已离开）。命令成功时回答以 OK 开头，失败时以 ERROR 开头。
+ *
+ * 所有网络收发和对局状态都只在主线程中处理。电脑搜索时引擎交给工作线程，
+ * 搜索完毕后工作线程把对局的指针写进唤醒管道，主线程收到后再发送着法。
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#else
+#include <sys/event.h>
+#endif
+
+#include "server.h"
+#include "pool.h"
+
+#define CLIENT_LINE 256                     // 一行命令的最大长度
+#define CLIENT_INPUT 4096                   // 每个连接读入但还未执行的数据的上限
+#define CLIENT_OUTPUT (16 * 1024)           // 每个连接待发送数据的上限，超出时断开该连接
+#define CLIENT_PAUSE (CLIENT_OUTPUT / 2)    // 待发送数据超过这么多时暂停执行和读取该连接的命令
+#define IDLE_SECONDS 600                    // 连接这么久没有发来命令就断开
+#define LISTEN_BACKLOG 64
+#define POLL_EVENTS 64                      // 每次取回的事件数
+#define POLL_TIMEOUT_MS 1000                // 事件循环至少每秒醒来一次，检查空闲连接
+#define MIN_MOVE_MS 50                      // 负载高时电脑每步思考时间的下限
+
+typedef struct Server Server;
+typedef struct Client Client;
+
+// 一局对局。id 为0表示空闲；引擎在空闲后保留，下一局重用
+typedef struct {
+    int id;
+    Server *server;
+    engine_t *engine;
+    Client *players[3];       // 按 BLACK、WHITE 索引，电脑一方和已离开的一方为 NULL
+    int ai;                   // 电脑执的颜色，双人对局为 EMPTY
+    int started;              // 双方都已入座
+    int over;                 // 已分出胜负或和棋
+    int searching;            // 电脑正在工作线程中搜索，期间主线程不碰引擎
+    volatile int abandoned;   // 搜索期间玩家已离开，还在排队的搜索不必进行
+    int searchStatus;         // engine_search() 的返回值
+    engine_result_t result;   // 工作线程的搜索结果
+} Game;
+
+// 一个连接。fd 为 -1 表示空闲
+struct Client {
+    int fd;
+    Game *game;
+    int color;                // 在对局中执的颜色
+    char in[CLIENT_INPUT];    // 读入但还未执行的命令
+    size_t inLength;
+    int discarding;           // 当前行太长，丢弃到行尾
+    char out[CLIENT_OUTPUT];  // 待发送的数据
+    size_t outLength;
+    int reading, writing;     // 事件循环中关注的事件
+    int closing;              // 发完待发送的数据后关闭
+    time_t lastActive;
+};
+
+struct Server {
+    const ServerConfig *config;
+    int poller;
+    int listenFd;
+    int wake[2];              // 唤醒管道：工作线程写入搜索完的对局
+    Client *clients;
+    int clientCount;
+    Game *games;
+    int gameCount;
+    int nextGameId;
+    int searches;             // 正在排队或搜索的对局数
+    ThreadPool *pool;
+};
+
+// 监听套接字和唤醒管道在事件循环中的标记，其余事件的标记为连接
+static char listenTag, wakeTag;
+
+static volatile sig_atomic_t stopping = 0;
+
+static void onSignal(int signal) {
+    (void)signal;
+    stopping = 1;
+}
+
+// ---- 事件循环：epoll 或 kqueue ----
+
+typedef struct {
+    void *tag;
+    int readable;   // 可读，或对方已关闭、出错
+    int writable;
+} PollEvent;
+
+static int pollerNew(void) {
+#ifdef __linux__
+    return epoll_create1(0);
+#else
+    return kqueue();
+#endif
+}
+
+/**
+ * @brief 登记或修改对某个描述符关注的事件
+ *
+ * @param poller 事件循环
+ * @param fd 描述符
+ * @param tag 事件的标记
+ * @param read 是否关注可读
+ * @param write 是否关注可写
+ * @param added 描述符是否已登记过
+ * @return int 成功返回0，失败返回-1
+ */
+static int pollerWatch(int poller, int fd, void *tag, int read, int write, int added) {
+#ifdef __linux__
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = (read ? EPOLLIN : 0) | (write ? EPOLLOUT : 0);
+    event.data.ptr = tag;
+    return epoll_ctl(poller, added ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd, &event);
+#else
+    struct kevent changes[2];
+    (void)added;
+    EV_SET(&changes[0], fd, EVFILT_READ, EV_ADD | (read ? EV_ENABLE : EV_DISABLE), 0, 0, tag);
+    EV_SET(&changes[1], fd, EVFILT_WRITE, EV_ADD | (write ? EV_ENABLE : EV_DISABLE), 0, 0, tag);
+    return kevent(poller, changes, 2, NULL, 0, NULL);
+#endif
+}
+
+/**
+ * @brief 等待事件
+ *
+ * @param poller 事件循环
+ * @param events 输出：发生的事件
+ * @param timeoutMs 最长等待时间（毫秒）
+ * @return int 事件数，出错返回-1
+ */
+static int pollerWait(int poller, PollEvent events[POLL_EVENTS], int timeoutMs) {
+#ifdef __linux__
+    struct epoll_event raw[POLL_EVENTS];
+    int n = epoll_wait(poller, raw, POLL_EVENTS, timeoutMs);
+    for (int k = 0; k < n; k++) {
+        events[k].tag = raw[k].data.ptr;
+        events[k].readable = (raw[k].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) != 0;
+        events[k].writable = (raw[k].events & EPOLLOUT) != 0;
+    }
+    return n;
+#else
+    struct kevent raw[POLL_EVENTS];
+    struct timespec timeout = { timeoutMs / 1000, (timeoutMs % 1000) * 1000000L };
+    int n = kevent(poller, NULL, 0, raw, POLL_EVENTS, &timeout);
+    for (int k = 0; k < n; k++) {
+        events[k].tag = raw[k].udata;
+        events[k].readable = raw[k].filter == EVFILT_READ || (raw[k].flags & (EV_EOF | EV_ERROR));
+        events[k].writable = raw[k].filter == EVFILT_WRITE;
+    }
+    return n;
+#endif
+}
+
+static int setNonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags < 0 ? -1 : fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+// ---- 连接的收发 ----
+
+/**
+ * @brief 按待发送数据的多少更新关注的事件
+ *
+ * 有待发送数据时关注可写；待发送数据过多时暂停读取，对方读走之后再继续，
+ * 不读回答只发命令的连接因此不会让服务器的缓冲无限增长。
+ */
+static void updateInterest(Server *s, Client *c) {
+    int reading = !c->closing && c->outLength < CLIENT_PAUSE && c->inLength < CLIENT_INPUT;
+    int writing = c->outLength > 0;
+    if (reading != c->reading || writing != c->writing) {
+        pollerWatch(s->poller, c->fd, c, reading, writing, 1);
+        c->reading = reading;
+        c->writing = writing;
+    }
+}
+
+/**
+ * @brief 向连接追加一行回答，待发送数据超出上限时改为断开该连接
+ */
+static void clientSend(Client *c, const char *format, ...)
+#ifdef __GNUC__
+    __attribute__((format(printf, 2, 3)))
+#endif
+    ;
+
+static void clientSend(Client *c, const char *format, ...) {
+    if (c == NULL || c->closing) return;
+    size_t room = CLIENT_OUTPUT - c->outLength;
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(c->out + c->outLength, room, format, args);
+    va_end(args);
+    if (n < 0 || (size_t)n >= room) {
+        c->closing = 1;   // 对方长期不读，放弃这个连接
+        c->outLength = 0;
+        return;
+    }
+    c->outLength += (size_t)n;
+}
+
+/**
+ * @brief 尽量写出待发送的数据
+ *
+ * @return int 连接仍可用返回0，出错返回-1
+ */
+static int clientFlush(Client *c) {
+    size_t sent = 0;
+    while (sent < c->outLength) {
+        ssize_t n = write(c->fd, c->out + sent, c->outLength - sent);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            return -1;
+        }
+        sent += (size_t)n;
+    }
+    memmove(c->out, c->out + sent, c->outLength - sent);
+    c->outLength -= sent;
+    return 0;
+}
+
+// ---- 对局 ----
+
+static const char *colorName(int color) {
+    return color == BLACK ? "BLACK" : "WHITE";
+}
+
+/**
+ * @brief 向对局中的两位玩家发送同一行
+ */
+static void broadcast(Game *g, const char *text) {
+    clientSend(g->players[BLACK], "%s\n", text);
+    clientSend(g->players[WHITE], "%s\n", text);
+}
+
+/**
+ * @brief 释放对局的座位，引擎留给下一局
+ */
+static void freeGame(Game *g) {
+    g->id = 0;
+    g->players[BLACK] = g->players[WHITE] = NULL;
+}
+
+/**
+ * @brief 分配一局新对局
+ *
+ * @return Game* 成功返回对局，没有空位或无法创建引擎返回 NULL
+ */
+static Game *newGame(Server *s, int ai) {
+    for (int k = 0; k < s->gameCount; k++) {
+        Game *g = &s->games[k];
+        if (g->id != 0) continue;
+        if (g->engine == NULL) {
+            g->engine = engine_new_limited(s->config->size, s->config->gameMegabytes);
+            if (g->engine == NULL) return NULL;
+        }
+        engine_init(g->engine);
+        engine_set_book(g->engine, ai != EMPTY ? s->config->book : NULL);
+        g->id = ++s->nextGameId;
+        g->server = s;
+        g->players[BLACK] = g->players[WHITE] = NULL;
+        g->ai = ai;
+        g->started = ai != EMPTY;
+        g->over = 0;
+        g->searching = 0;
+        g->abandoned = 0;
+        return g;
+    }
+    return NULL;
+}
+
+/**
+ * @brief 工作线程中为电脑搜索并落子，完成后唤醒主线程
+ */
+static void searchTask(void *arg) {
+    Game *g = arg;
+    g->searchStatus = g->abandoned ? -1 : engine_search(g->engine, &g->result);
+    if (g->searchStatus == 0) {
+        engine_make_move(g->engine, g->result.row, g->result.col);
+    }
+    // 不超过 PIPE_BUF 的写入是原子的
+    ssize_t n;
+    do {
+        n = write(g->server->wake[1], &g, sizeof(g));
+    } while (n < 0 && errno == EINTR);
+}
+
+/**
+ * @brief 把电脑的下一步交给线程池
+ *
+ * 排队和正在进行的搜索多于工作线程时，按比例缩短这一步的思考时间，
+ * 服务器过载时电脑走得弱一些，但每一步的等待时间仍有上限。
+ */
+static void startSearch(Server *s, Game *g) {
+    int busy = s->searches + 1;
+    long ms = s->config->moveMs;
+    if (busy > s->config->jobs) {
+        ms = ms * s->config->jobs / busy;
+    }
+    engine_set_time_limit(g->engine, ms > MIN_MOVE_MS ? (int)ms : MIN_MOVE_MS);
+    g->searching = 1;
+    s->searches++;
+    poolSubmit(s->pool, searchTask, g);  // 队列容量不少于对局数，不会阻塞
+}
+
+/**
+ * @brief 一步棋之后检查胜负，分出结果时通知双方
+ *
+ * @return int 对局结束返回1
+ */
+static int checkGameOver(Game *g, int row, int col) {
+    int size = engine_size(g->engine);
+    if (engine_check_win(g->engine, row, col)) {
+        char text[16];
+        snprintf(text, sizeof(text), "WIN %s", colorName(engine_stone(g->engine, row, col)));
+        broadcast(g, text);
+        g->over = 1;
+    } else if (engine_move_count(g->engine) == size * size) {
+        broadcast(g, "DRAW");
+        g->over = 1;
+    }
+    return g->over;
+}
+
+/**
+ * @brief 轮到下一方：电脑开始搜索，玩家收到 TURN
+ */
+static void nextTurn(Server *s, Game *g) {
+    int side = engine_to_move(g->engine);
+    if (side == g->ai) {
+        startSearch(s, g);
+    } else {
+        clientSend(g->players[side], "TURN\n");
+    }
+}
+
+/**
+ * @brief 主线程取回电脑的着法
+ */
+static void finishSearch(Server *s, Game *g) {
+    g->searching = 0;
+    s->searches--;
+    Client *human = g->players[BLACK + WHITE - g->ai];
+    if (human == NULL) {
+        freeGame(g);  // 玩家在电脑思考时离开了
+        return;
+    }
+    if (g->searchStatus != 0) {
+        broadcast(g, "DRAW");
+        g->over = 1;
+        return;
+    }
+    clientSend(human, "MOVE %d %d\n", g->result.row, g->result.col);
+    if (!checkGameOver(g, g->result.row, g->result.col)) {
+        nextTurn(s, g);
+    }
+}
+
+/**
+ * @brief 玩家离开对局：对手收到 LEFT，电脑正在思考时对局留到搜索结束再释放
+ */
+static void leaveGame(Client *c) {
+    Game *g = c->game;
+    if (g == NULL) return;
+    g->players[c->color] = NULL;
+    c->game = NULL;
+    Client *other = g->players[BLACK + WHITE - c->color];
+    if (other != NULL) {
+        if (!g->over) clientSend(other, "LEFT\n");
+        other->game = NULL;
+        g->players[other->color] = NULL;
+    }
+    if (g->searching) {
+        g->abandoned = 1;
+    } else {
+        freeGame(g);
+    }
+}
+
+// ---- 命令 ----
+
+static void commandHelp(Client *c) {
+    clientSend(c, "OK commands: NEW AI [BLACK|WHITE], NEW PVP, JOIN N, MOVE ROW COL, BOARD, LEAVE, QUIT\n");
+}
+
+static void commandNew(Server *s, Client *c, const char *kind, const char *color) {
+    int ai;
+    if (kind != NULL && strcasecmp(kind, "PVP") == 0 && color == NULL) {
+        ai = EMPTY;
+    } else if (kind != NULL && strcasecmp(kind, "AI") == 0) {
+        if (color == NULL || strcasecmp(color, "BLACK") == 0) {
+            ai = WHITE;
+        } else if (strcasecmp(color, "WHITE") == 0) {
+            ai = BLACK;
+        } else {
+            clientSend(c, "ERROR usage: NEW AI [BLACK|WHITE]\n");
+            return;
+        }
+    } else {
+        clientSend(c, "ERROR usage: NEW AI [BLACK|WHITE] or NEW PVP\n");
+        return;
+    }
+
+    leaveGame(c);
+    Game *g = newGame(s, ai);
+    if (g == NULL) {
+        clientSend(c, "ERROR server busy, try again later\n");
+        return;
+    }
+    c->game = g;
+    c->color = ai == EMPTY ? BLACK : BLACK + WHITE - ai;
+    g->players[c->color] = c;
+    if (ai == EMPTY) {
+        clientSend(c, "OK game %d BLACK, waiting for an opponent\n", g->id);
+        return;
+    }
+    clientSend(c, "OK game %d %s\n", g->id, colorName(c->color));
+    nextTurn(s, g);
+}
+
+static void commandJoin(Server *s, Client *c, const char *idText) {
+    int id = idText != NULL ? atoi(idText) : 0;
+    Game *g = NULL;
+    for (int k = 0; k < s->gameCount && id > 0; k++) {
+        if (s->games[k].id == id) g = &s->games[k];
+    }
+    if (g == NULL || g->ai != EMPTY || g->started || g->players[BLACK] == c) {
+        clientSend(c, "ERROR no such game waiting for an opponent\n");
+        return;
+    }
+    leaveGame(c);
+    c->game = g;
+    c->color = WHITE;
+    g->players[WHITE] = c;
+    g->started = 1;
+    clientSend(c, "OK game %d WHITE\n", g->id);
+    clientSend(g->players[BLACK], "START\n");
+    nextTurn(s, g);
+}
+
+static void commandMove(Server *s, Client *c, const char *rowText, const char *colText) {
+    Game *g = c->game;
+    char *end;
+    if (g == NULL || !g->started || g->over) {
+        clientSend(c, "ERROR not in a game\n");
+        return;
+    }
+    if (g->searching || engine_to_move(g->engine) != c->color) {
+        clientSend(c, "ERROR not your turn\n");
+        return;
+    }
+    long row = rowText != NULL ? strtol(rowText, &end, 10) : -1;
+    if (rowText == NULL || *end != '\0') row = -1;
+    long col = colText != NULL ? strtol(colText, &end, 10) : -1;
+    if (colText == NULL || *end != '\0') col = -1;
+    int size = engine_size(g->engine);
+    if (row < 0 || row >= size || col < 0 || col >= size ||
+        engine_make_move(g->engine, (int)row, (int)col) != 0) {
+        clientSend(c, "ERROR invalid move\n");
+        return;
+    }
+    clientSend(c, "OK\n");
+    clientSend(g->players[BLACK + WHITE - c->color], "MOVE %ld %ld\n", row, col);
+    if (!checkGameOver(g, (int)row, (int)col)) {
+        nextTurn(s, g);
+    }
+}
+
+static void commandBoard(Client *c) {
+    Game *g = c->game;
+    if (g == NULL) {
+        clientSend(c, "ERROR not in a game\n");
+        return;
+    }
+    // 电脑思考期间引擎在工作线程中，棋盘也在变化，不能读取
+    if (g->searching) {
+        clientSend(c, "ERROR the AI is thinking\n");
+        return;
+    }
+    int size = engine_size(g->engine);
+    char line[ENGINE_MAX_SIZE + 2];
+    for (int i = 0; i < size; i++) {
+        for (int j = 0; j < size; j++) {
+            int stone = engine_stone(g->engine, i, j);
+            line[j] = stone == BLACK ? 'X' : stone == WHITE ? 'O' : '.';
+        }
+        line[size] = '\0';
+        clientSend(c, "%s\n", line);
+    }
+    clientSend(c, "OK\n");
+}
+
+/**
+ * @brief 执行一行命令
+ */
+static void handleLine(Server *s, Client *c, char *line) {
+    char *save = NULL;
+    char *command = strtok_r(line, " \t\r", &save);
+    char *arg1 = strtok_r(NULL, " \t\r", &save);
+    char *arg2 = strtok_r(NULL, " \t\r", &save);
+    if (command == NULL) return;
+
+    if (strcasecmp(command, "HELP") == 0) {
+        commandHelp(c);
+    } else if (strcasecmp(command, "NEW") == 0) {
+        commandNew(s, c, arg1, arg2);
+    } else if (strcasecmp(command, "JOIN") == 0) {
+        commandJoin(s, c, arg1);
+    } else if (strcasecmp(command, "MOVE") == 0) {
+        commandMove(s, c, arg1, arg2);
+    } else if (strcasecmp(command, "BOARD") == 0) {
+        commandBoard(c);
+    } else if (strcasecmp(command, "LEAVE") == 0) {
+        leaveGame(c);
+        clientSend(c, "OK\n");
+    } else if (strcasecmp(command, "QUIT") == 0) {
+        clientSend(c, "OK bye\n");
+        leaveGame(c);
+        c->closing = 1;
+    } else {
+        clientSend(c, "ERROR unknown command, type HELP\n");
+    }
+}
+
+// ---- 连接的建立与关闭 ----
+
+static void closeClient(Client *c) {
+    leaveGame(c);
+    close(c->fd);  // 关闭后描述符自动从事件循环中移除
+    c->fd = -1;
+}
+
+static void acceptClients(Server *s) {
+    while (1) {
+        int fd = accept(s->listenFd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            return;  // EAGAIN：已全部接受；描述符用完等其他错误时下次再试
+        }
+        Client *c = NULL;
+        for (int k = 0; k < s->clientCount && c == NULL; k++) {
+            if (s->clients[k].fd < 0) c = &s->clients[k];
+        }
+        if (c == NULL || setNonblocking(fd) != 0) {
+            // 满员时告知对方后立即关闭，不让新连接拖慢已有的对局
+            static const char full[] = "ERROR server full, try again later\n";
+            ssize_t ignored = write(fd, full, sizeof(full) - 1);
+            (void)ignored;
+            close(fd);
+            continue;
+        }
+        memset(c, 0, sizeof(*c));
+        c->fd = fd;
+        c->reading = 1;
+        c->lastActive = time(NULL);
+        if (pollerWatch(s->poller, fd, c, 1, 0, 0) != 0) {
+            close(fd);
+            c->fd = -1;
+            continue;
+        }
+        clientSend(c, "OK gobang server, %dx%d board, type HELP for commands\n", s->config->size, s->config->size);
+    }
+}
+
+/**
+ * @brief 逐行执行已读入的命令
+ *
+ * 待发送数据超过 CLIENT_PAUSE 时停下，余下的命令留到对方读走回答之后再执行。
+ * 一条命令的回答远小于 CLIENT_OUTPUT - CLIENT_PAUSE，所以连续发命令而不读回答的连接只会被放慢。
+ */
+static void runCommands(Server *s, Client *c) {
+    size_t used = 0;
+    while (!c->closing && c->outLength < CLIENT_PAUSE) {
+        char *line = c->in + used;
+        char *end = memchr(line, '\n', c->inLength - used);
+        if (end == NULL) {
+            // 缓冲区已满仍没有行尾，丢弃这一行
+            if (used == 0 && c->inLength == CLIENT_INPUT) {
+                c->discarding = 1;
+                c->inLength = 0;
+            }
+            break;
+        }
+        *end = '\0';
+        used = (size_t)(end - c->in) + 1;
+        if (c->discarding || end - line >= CLIENT_LINE) {
+            clientSend(c, "ERROR line too long\n");
+            c->discarding = 0;
+        } else {
+            handleLine(s, c, line);
+        }
+    }
+    memmove(c->in, c->in + used, c->inLength - used);
+    c->inLength -= used;
+}
+
+/**
+ * @brief 读入连接发来的数据并执行
+ *
+ * @return int 连接仍可用返回0，对方关闭或出错返回-1
+ */
+static int readClient(Server *s, Client *c) {
+    ssize_t n = read(c->fd, c->in + c->inLength, CLIENT_INPUT - c->inLength);
+    if (n == 0) return -1;
+    if (n < 0) return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR ? 0 : -1;
+    c->inLength += (size_t)n;
+    c->lastActive = time(NULL);
+    runCommands(s, c);
+    return 0;
+}
+
+/**
+ * @brief 写出待发送的数据，出错或发完最后的回答时关闭连接
+ */
+static void flushClient(Server *s, Client *c) {
+    if (clientFlush(c) != 0 || (c->closing && c->outLength == 0)) {
+        closeClient(c);
+        return;
+    }
+    if (c->inLength > 0 && c->outLength < CLIENT_PAUSE) {
+        runCommands(s, c);  // 暂停时留下的命令
+    }
+    updateInterest(s, c);
+}
+
+/**
+ * @brief 处理一个连接上的事件
+ */
+static void serveClient(Server *s, Client *c, int readable, int writable) {
+    if (c->fd < 0) return;  // 同一批事件中已被关闭
+    if (readable && c->reading && readClient(s, c) != 0) {
+        closeClient(c);
+        return;
+    }
+    (void)writable;
+    flushClient(s, c);  // 同时按缓冲区的状态更新关注的事件
+}
+
+/**
+ * @brief 取回工作线程搜索完的对局，把电脑的着法发给玩家
+ */
+static void collectSearches(Server *s) {
+    Game *g;
+    while (read(s->wake[0], &g, sizeof(g)) == (ssize_t)sizeof(g)) {
+        finishSearch(s, g);
+    }
+}
+
+/**
+ * @brief 每轮事件之后检查所有连接：断开太久没有发来命令的连接，写出新的回答
+ *
+ * 一条命令也会给对手带来输出，电脑的着法也在这里写出。
+ * 已在等待可写事件的连接留给事件循环，不反复尝试。
+ */
+static void sweepClients(Server *s) {
+    time_t now = time(NULL);
+    for (int k = 0; k < s->clientCount; k++) {
+        Client *c = &s->clients[k];
+        if (c->fd < 0) continue;
+        if (now - c->lastActive > IDLE_SECONDS && !c->closing) {
+            clientSend(c, "ERROR idle timeout\n");
+            c->closing = 1;
+        }
+        if ((c->outLength > 0 && !c->writing) || c->closing) {
+            flushClient(s, c);
+        }
+    }
+}
+
+/**
+ * @brief 在所有地址上监听指定端口
+ *
+ * @return int 监听套接字，失败返回-1
+ */
+static int openListener(int port) {
+    struct addrinfo hints, *list, *a;
+    char service[16];
+    int fd = -1;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+    snprintf(service, sizeof(service), "%d", port);
+    if (getaddrinfo(NULL, service, &hints, &list) != 0) return -1;
+
+    // 优先 IPv6 地址，系统允许时同时接受 IPv4 连接
+    for (int pass = 0; pass < 2 && fd < 0; pass++) {
+        for (a = list; a != NULL && fd < 0; a = a->ai_next) {
+            if ((a->ai_family == AF_INET6) != (pass == 0)) continue;
+            fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+            if (fd < 0) continue;
+            int on = 1;
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+            if (bind(fd, a->ai_addr, a->ai_addrlen) != 0 || listen(fd, LISTEN_BACKLOG) != 0 ||
+                setNonblocking(fd) != 0) {
+                close(fd);
+                fd = -1;
+            }
+        }
+    }
+    freeaddrinfo(list);
+    return fd;
+}
+
+/**
+ * @brief 释放服务器的所有资源，先等工作线程中正在进行的搜索结束，排队的搜索不再进行
+ */
+static void closeServer(Server *s) {
+    for (int k = 0; s->games != NULL && k < s->gameCount; k++) {
+        if (s->games[k].searching) s->games[k].abandoned = 1;
+    }
+    poolDestroy(s->pool);
+    for (int k = 0; s->clients != NULL && k < s->clientCount; k++) {
+        if (s->clients[k].fd >= 0) close(s->clients[k].fd);
+    }
+    for (int k = 0; s->games != NULL && k < s->gameCount; k++) {
+        engine_free(s->games[k].engine);
+    }
+    free(s->clients);
+    free(s->games);
+    if (s->wake[0] >= 0) close(s->wake[0]);
+    if (s->wake[1] >= 0) close(s->wake[1]);
+    if (s->listenFd >= 0) close(s->listenFd);
+    if (s->poller >= 0) close(s->poller);
+}
+
+int runServer(const ServerConfig *config) {
+    Server server, *s = &server;
+    memset(s, 0, sizeof(*s));
+    s->config = config;
+    s->wake[0] = s->wake[1] = -1;
+    s->clientCount = config->clients;
+    // 电脑思考时离开的玩家可以马上开新局，旧局留到搜索结束，所以对局数是连接数的两倍
+    s->gameCount = config->clients * 2;
+
+    s->listenFd = openListener(config->port);
+    if (s->listenFd < 0) {
+        printf("Cannot listen on port %d\n", config->port);
+        s->poller = -1;
+        closeServer(s);
+        return 1;
+    }
+    s->poller = pollerNew();
+    s->clients = calloc((size_t)s->clientCount, sizeof(Client));
+    s->games = calloc((size_t)s->gameCount, sizeof(Game));
+    for (int k = 0; s->clients != NULL && k < s->clientCount; k++) {
+        s->clients[k].fd = -1;
+    }
+    s->pool = poolCreate(config->jobs, s->gameCount);
+    if (s->poller < 0 || s->clients == NULL || s->games == NULL || s->pool == NULL ||
+        pipe(s->wake) != 0 || setNonblocking(s->wake[0]) != 0 ||
+        pollerWatch(s->poller, s->listenFd, &listenTag, 1, 0, 0) != 0 ||
+        pollerWatch(s->poller, s->wake[0], &wakeTag, 1, 0, 0) != 0) {
+        printf("Cannot start the server.\n");
+        closeServer(s);
+        return 1;
+    }
+    // 对方断开后继续写只会得到 EPIPE，不要让信号结束进程
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = SIG_IGN;
+    sigaction(SIGPIPE, &action, NULL);
+    action.sa_handler = onSignal;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    printf("Serving %dx%d games on port %d, up to %d clients, %d AI threads, %zu MB per game\n",
+           config->size, config->size, config->port, config->clients, config->jobs, config->gameMegabytes);
+    fflush(stdout);
+
+    PollEvent events[POLL_EVENTS];
+    while (!stopping) {
+        int n = pollerWait(s->poller, events, POLL_TIMEOUT_MS);
+        if (n < 0 && errno != EINTR) {
+            printf("Event loop failed.\n");
+            break;
+        }
+        for (int k = 0; k < n; k++) {
+            if (events[k].tag == &listenTag) {
+                acceptClients(s);
+            } else if (events[k].tag == &wakeTag) {
+                collectSearches(s);
+            } else {
+                serveClient(s, events[k].tag, events[k].readable, events[k].writable);
+            }
+        }
+        sweepClients(s);
+    }
+
+    printf("Server stopped.\n");
+    closeServer(s);
+    return 0;
+}
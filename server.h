@@ -0,0 +1,45 @@
+/*
+ * 五子棋游戏 - 网络对局服务器
+ * 版权所有 (C) 2024 [大龙软件 bigdragonsoft.com]
+ *
+ * 一个进程在一个事件循环（Linux 上为 epoll，BSD 和 macOS 上为 kqueue）中
+ * 服务多个 TCP 连接，每个连接可以与电脑对局，或与另一个连接对局。
+ * 协议按行收发文本，可以直接用 telnet 或 nc 连接，命令见 server.c。
+ * 电脑的搜索在固定大小的线程池中进行，不会阻塞网络收发。
+ */
+
+#ifndef GOBANG_SERVER_H
+#define GOBANG_SERVER_H
+
+#include <stddef.h>
+
+#include "engine.h"
+#include "book.h"
+
+#define SERVER_DEFAULT_CLIENTS 64     // 默认的最大连接数
+#define SERVER_DEFAULT_MOVE_MS 2000   // 默认的电脑每步思考时间上限（毫秒）
+#define SERVER_DEFAULT_GAME_MB 1      // 默认的每局引擎内存上限（MB）
+#define SERVER_MAX_CLIENTS 4096       // 最大连接数的上限，保证搜索完的对局都能写进唤醒管道
+
+/**
+ * 服务器的设置
+ */
+typedef struct {
+    int port;               // 监听的 TCP 端口
+    int size;               // 棋盘边长
+    int clients;            // 最大连接数，超出时新连接收到错误后被关闭
+    int jobs;               // 电脑搜索的工作线程数
+    int moveMs;             // 电脑每步思考时间上限，排队的搜索多于工作线程时按比例缩短
+    size_t gameMegabytes;   // 每局引擎的内存上限，全部在创建时分配，之后落子和搜索都不再分配内存
+    const Book *book;       // 电脑使用的开局库，可以为 NULL
+} ServerConfig;
+
+/**
+ * @brief 运行服务器，直到收到 SIGINT 或 SIGTERM
+ *
+ * @param config 服务器设置
+ * @return int 进程退出码：正常结束返回0，无法监听或内存不足返回1
+ */
+int runServer(const ServerConfig *config);
+
+#endif